@@ -0,0 +1,24 @@
+#include"../../timer.h"
+#include"../../../include/fast_io.h"
+#include"../../../include/fast_io_device.h"
+#include"../../../include/fast_io_legacy.h"
+#include<thread>
+
+/*
+Same as iobuf_file_mutex.cc, but 8 threads print the 10M lines into one stream, so every println contends for the lock.
+*/
+
+int main()
+{
+	constexpr std::size_t N(10000000);
+	constexpr std::size_t threads(8);
+	fast_io::timer t("output");
+	fast_io::obuf_file_mutex obf("obuf_file_mutex_threads.txt");
+	std::vector<std::jthread> pool;
+	for(std::size_t j{};j!=threads;++j)
+		pool.emplace_back([&obf,j]
+		{
+			for(std::size_t i{j*(N/threads)},e{i+N/threads};i!=e;++i)
+				println(obf,i);
+		});
+}
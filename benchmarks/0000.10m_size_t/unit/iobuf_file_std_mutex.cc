@@ -0,0 +1,26 @@
+#include"../../timer.h"
+#include"../../../include/fast_io.h"
+#include"../../../include/fast_io_device.h"
+#include"../../../include/fast_io_legacy.h"
+
+/*
+Same as iobuf_file_mutex.cc, but locks with std::mutex instead of the default io_mutex.
+*/
+
+int main()
+{
+	constexpr std::size_t N(10000000);
+	{
+	fast_io::timer t("output");
+	fast_io::basic_iomutex<fast_io::obuf_file,std::mutex> obf("obuf_file_std_mutex.txt");
+	for(std::size_t i{};i!=N;++i)
+		println(obf,i);
+	}
+	std::vector<std::size_t> vec(N);
+	{
+	fast_io::timer t("input");
+	fast_io::basic_iomutex<fast_io::ibuf_file,std::mutex> ibf("obuf_file_std_mutex.txt");
+	for(std::size_t i{};i!=N;++i)
+		scan(ibf,vec[i]);
+	}
+}
@@ -2,7 +2,7 @@
 #include"../../include/fast_io_device.h"
 #include"../../include/fast_io_async.h"
 
-inline fast_io::task io_task(fast_io::win32_io_observer iocp)
+inline fast_io::task<> io_task(fast_io::win32_io_observer iocp)
 {
 	fast_io::win32_file file(fast_io::io_async,iocp,"w.txt",fast_io::open_mode::out|fast_io::open_mode::binary|fast_io::open_mode::no_block);
 	co_await fast_io::async_println(iocp,file,"Hello World ",5," ",6," ",8," ",9," ",4.2);
@@ -10,8 +10,6 @@ inline fast_io::task io_task(fast_io::win32_io_observer iocp)
 
 int main()
 {
-	using namespace std::chrono_literals;
 	fast_io::win32_file iocp(fast_io::io_async);
-	io_task(iocp);
-	for(;;fast_io::io_async_wait_timeout(iocp,1ms));
+	fast_io::io_async_run(iocp,io_task(iocp));
 }
\ No newline at end of file
@@ -4,7 +4,7 @@
 #include<coroutine>
 #include"../../include/fast_io_hosted/async_coro.h"
 
-inline fast_io::task io_task(fast_io::io_uring_observer ior)
+inline fast_io::task<> io_task(fast_io::io_uring_observer ior)
 {
 	fast_io::onative_file nv("test.txt");
 	std::ptrdiff_t offset{};
@@ -14,8 +14,6 @@ inline fast_io::task io_task(fast_io::io_uring_observer ior)
 
 int main()
 {
-	using namespace std::chrono_literals;
 	fast_io::io_uring ior(fast_io::io_async);
-	io_task(ior);
-	for(;;fast_io::io_async_wait_timeout(ior,1ms));
+	fast_io::io_async_run(ior,io_task(ior));
 }
@@ -4,7 +4,7 @@
 #include"../../include/fast_io_legacy.h"
 #include<fstream>
 //probably only works for Linux
-inline fast_io::task io_task(fast_io::io_async_observer ioa)
+inline fast_io::task<> io_task(fast_io::io_async_observer ioa)
 {
 	std::ofstream fout("ofstream.txt",std::ofstream::binary);
 	fast_io::filebuf_io_observer fiob{fout.rdbuf()};
@@ -13,8 +13,6 @@ inline fast_io::task io_task(fast_io::io_async_observer ioa)
 
 int main()
 {
-	using namespace std::chrono_literals;
 	fast_io::io_async_scheduler ioa(fast_io::io_async);
-	io_task(ioa);
-	for(;;fast_io::io_async_wait_timeout(ioa,1ms));
+	fast_io::io_async_run(ioa,io_task(ioa));
 }
\ No newline at end of file
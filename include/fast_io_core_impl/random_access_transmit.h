@@ -21,7 +21,7 @@ inline constexpr std::uintmax_t zero_copy_random_access_transmit_impl(output& ou
 template<output_stream output,input_stream input>
 inline constexpr std::uintmax_t zero_copy_random_access_transmit_impl(output& outp,input& inp,std::intmax_t offset,std::uintmax_t sz)
 {
-	auto ret(zero_copy_transmit<true,true>(outp,inp,offset,sz)); 
+	auto ret(zero_copy_transmit<true,true>(outp,inp,sz,offset));
 	if(ret.second)
 	{
 		offset+=static_cast<std::intmax_t>(ret.first);
@@ -38,7 +38,7 @@ inline constexpr auto random_access_transmit_impl(output& outp,input& inp,std::i
 	{
 		typename input::lock_guard_type lg{mutex(inp)};
 		decltype(auto) uh{unlocked_handle(inp)};
-		return random_access_transmit_impl(outp,uh,std::forward<Args>(args)...);
+		return random_access_transmit_impl(outp,uh,offset,std::forward<Args>(args)...);
 	}
 	else
 	{
@@ -80,18 +80,18 @@ inline constexpr auto random_access_transmit_impl(output& outp,input& inp,std::i
 
 }
 
-template<output_stream output,input_stream input,std::integral sz_type,std::integral offset_type>
+template<output_stream output,input_stream input,std::integral offset_type,std::integral sz_type>
 requires fast_io::random_access_stream<input>
-inline constexpr void print_define(output& outp,manip::random_access_transmission<input,sz_type,offset_type> ref)
+inline constexpr void print_define(output& outp,manip::random_access_transmission<input,offset_type,sz_type> ref)
 {
 	ref.transmitted=static_cast<sz_type>(details::random_access_transmit_impl(outp,ref.reference,ref.offset));
 }
 
-template<output_stream output,input_stream input,std::integral sz_type,std::integral offset_type>
+template<output_stream output,input_stream input,std::integral offset_type,std::integral sz_type>
 requires fast_io::random_access_stream<input>
-inline constexpr void print_define(output& outp,manip::random_access_transmission_with_size<input,sz_type,offset_type> ref)
+inline constexpr void print_define(output& outp,manip::random_access_transmission_with_size<input,offset_type,sz_type> ref)
 {
-	ref.transmitted=static_cast<sz_type>(details::random_access_transmit_impl(outp,ref.reference,ref.offset,ref.bytes));
+	ref.transmitted=static_cast<sz_type>(details::random_access_transmit_impl(outp,ref.reference,ref.offset,ref.size));
 }
 
 template<output_stream output,std::integral offset_type,input_stream input>
@@ -99,7 +99,7 @@ requires fast_io::random_access_stream<input>
 inline constexpr std::uintmax_t random_access_transmit(output&& outp,offset_type offset,input&& in)
 {
 	std::uintmax_t transmitted{};
-	print(outp,manip::random_access_transmission<input,offset_type,std::uintmax_t>(transmitted,offset,in));
+	print(outp,manip::random_access_transmission<input,offset_type,std::uintmax_t>{transmitted,offset,in});
 	return transmitted;
 }
 
@@ -108,7 +108,7 @@ requires fast_io::random_access_stream<input>
 inline constexpr sz_type random_access_transmit(output&& outp,offset_type offset,input&& in,sz_type bytes)
 {
 	sz_type transmitted{};
-	print(outp,manip::random_access_transmission_with_size<input,offset_type,std::uintmax_t>(transmitted,offset,in,bytes));
+	print(outp,manip::random_access_transmission_with_size<input,offset_type,sz_type>{transmitted,offset,in,bytes});
 	return transmitted;
 }
 
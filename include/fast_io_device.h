@@ -25,8 +25,20 @@ using basic_iobuf_file = basic_iobuf<basic_ionative_file<char_type>>;
 using inative_file = input_file_wrapper<native_file>;
 using onative_file = output_file_wrapper<native_file>;
 using ionative_file = io_file_wrapper<native_file>;
+#if defined(__linux__)
+using idirect_native_file = basic_file_wrapper<native_file,open_mode::in|open_mode::binary|open_mode::direct>;
+using odirect_native_file = basic_file_wrapper<native_file,open_mode::out|open_mode::binary|open_mode::direct>;
+using ibuf_direct_file = basic_direct_ibuf<idirect_native_file>;
+using obuf_direct_file = basic_direct_obuf<odirect_native_file>;
+#endif
 #if !defined(__NEWLIB__)
-using omap_file = basic_omap<basic_file_wrapper<native_file,open_mode::trunc|open_mode::out|open_mode::binary>,native_file_map>;
+#if !defined(__WINNT__) && !defined(_MSC_VER)
+using ibuf_huge_page_file = basic_ibuf<inative_file,basic_huge_page_buf_handler<char,false,2097152>>;
+using obuf_huge_page_file = basic_obuf<onative_file,false,basic_huge_page_buf_handler<char,false,2097152>>;
+using imap_file = basic_imap<inative_file>;
+using imap_window_file = basic_imap_window<inative_file>;
+#endif
+using omap_file = basic_omap<basic_file_wrapper<native_file,open_mode::trunc|open_mode::creat|open_mode::in|open_mode::out|open_mode::binary>,native_file_map>;
 #endif
 template<output_stream output>
 using basic_obuf_text = basic_obuf<basic_indirect_obuffer_constructor_source_type<typename output::char_type,output,transforms::binary_to_text<>>,true>;
@@ -38,12 +50,25 @@ using ibuf_file = basic_ibuf<inative_file>;
 using obuf_file = basic_obuf<onative_file>;
 using iobuf_file = basic_iobuf<ionative_file>;
 
+template<std::integral char_type>
+using basic_ibuf_adaptive_file = basic_ibuf<basic_inative_file<char_type>,basic_adaptive_buf_handler<char_type>>;
+template<std::integral char_type>
+using basic_obuf_adaptive_file = basic_obuf<basic_onative_file<char_type>,false,basic_adaptive_buf_handler<char_type>>;
+
+using ibuf_adaptive_file = basic_ibuf_adaptive_file<char>;
+using obuf_adaptive_file = basic_obuf_adaptive_file<char>;
+
 using ibuf_text_file = basic_ibuf_text<inative_file>;
 using obuf_text_file = basic_obuf_text<onative_file>;
 #if !defined(__NEWLIB__)||defined(_GLIBCXX_HAS_GTHREADS)
+using ibuf_pool_file = basic_ibuf<inative_file,basic_pool_buf_handler<char>>;
+using obuf_pool_file = basic_obuf<onative_file,false,basic_pool_buf_handler<char>>;
+using obuf_background_file = basic_background_obuf<onative_file>;
+using ring_log_file = basic_ring_log<obuf_file>;
 using ibuf_file_mutex = basic_iomutex<ibuf_file>;
 using obuf_file_mutex = basic_iomutex<obuf_file>;
 using iobuf_file_mutex = basic_iomutex<iobuf_file>;
+using obatched_file_mutex = basic_batched_iomutex<onative_file>;
 #endif
 // utf-8
 using u8pipe = io_wrapper<u8native_pipe>;
@@ -60,6 +85,7 @@ using u8iobuf_file = basic_iobuf<u8ionative_file>;
 using u8ibuf_file_mutex = basic_iomutex<u8ibuf_file>;
 using u8obuf_file_mutex = basic_iomutex<u8obuf_file>;
 using u8iobuf_file_mutex = basic_iomutex<u8iobuf_file>;
+using u8obatched_file_mutex = basic_batched_iomutex<u8onative_file>;
 #endif
 using wpipe = io_wrapper<wnative_pipe>;
 
@@ -74,6 +100,7 @@ using wiobuf_file = basic_iobuf<wionative_file>;
 using wibuf_file_mutex = basic_iomutex<wibuf_file>;
 using wobuf_file_mutex = basic_iomutex<wobuf_file>;
 using wiobuf_file_mutex = basic_iomutex<wiobuf_file>;
+using wobatched_file_mutex = basic_batched_iomutex<wonative_file>;
 #endif
 
 template<std::integral new_code_type,output_stream output>
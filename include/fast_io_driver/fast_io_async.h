@@ -1,3 +1,4 @@
 #pragma once
-#include"fast_io_hosted.h"
-//#include"fast_io_async/model.h"
\ No newline at end of file
+#include"../fast_io_network.h"
+#include"../fast_io_hosted/async_transmit.h"
+#include"fast_io_async/model.h"
@@ -218,6 +218,368 @@ inline void modify_control(handle_pool& pool,output& out,event e,std::integral a
 		throw posix_error();
 }
 */
+
+//invoke gets the byte count, or a negated errno when the operation failed
+class overlapped_base
+{
+public:
+#if __cpp_constexpr >= 201907L
+	constexpr
+#endif
+	virtual void invoke(std::ptrdiff_t) noexcept = 0;
+#if __cpp_constexpr >= 201907L
+	constexpr
+#endif
+	virtual ~overlapped_base()=default;
+};
+
+template<typename T>
+class overlapped_derived:public overlapped_base
+{
+public:
+	T callback;
+	template<typename... Args>
+	requires std::constructible_from<T,Args...>
+	constexpr overlapped_derived(std::in_place_t,Args&& ...args):callback(std::forward<Args>(args)...){}
+#if __cpp_constexpr >= 201907L
+	constexpr
+#endif
+	void invoke(std::ptrdiff_t res) noexcept override
+	{
+		callback(res);
+	}
+};
+
+class overlapped_observer
+{
+public:
+	using native_handle_type = overlapped_base*;
+	native_handle_type handle{};
+#if __cpp_constexpr >= 201907L
+	constexpr
+#endif
+	void operator()(std::ptrdiff_t res) noexcept
+	{
+		handle->invoke(res);
+	}
+	constexpr native_handle_type const& native_handle() const noexcept
+	{
+		return handle;
+	}
+	constexpr native_handle_type& native_handle() noexcept
+	{
+		return handle;
+	}
+	constexpr native_handle_type release() noexcept
+	{
+		auto temp{handle};
+		handle={};
+		return temp;
+	}
+};
+
+class overlapped:public overlapped_observer
+{
+public:
+	using native_handle_type = overlapped_base*;
+	using observer_type = overlapped_observer;
+	template<typename T>
+	using derived_type = overlapped_derived<T>;
+	constexpr overlapped()=default;
+	constexpr overlapped(native_handle_type hd):overlapped_observer{hd}{}
+
+	template<typename T,typename... Args>
+	requires std::constructible_from<T,Args...>
+#if __cpp_constexpr_dynamic_alloc >= 201907L
+	constexpr
+#endif
+	overlapped(std::in_place_type_t<T>,Args&& ...args):
+		overlapped_observer{new overlapped_derived<T>(std::in_place,std::forward<Args>(args)...)}{}
+	template<typename Func>
+#if __cpp_constexpr_dynamic_alloc >= 201907L
+	constexpr
+#endif
+	overlapped(std::in_place_t,Func&& func):overlapped(std::in_place_type<std::remove_cvref_t<Func>>,std::forward<Func>(func)){}
+
+	overlapped(overlapped const&)=delete;
+	overlapped& operator=(overlapped const&)=delete;
+	constexpr overlapped(overlapped&& bmv) noexcept : overlapped_observer{bmv.release()}{}
+
+#if __cpp_constexpr_dynamic_alloc >= 201907L
+	constexpr
+#endif
+	overlapped& operator=(overlapped&& bmv) noexcept
+	{
+		if(bmv.native_handle()==this->native_handle())
+			return *this;
+		delete this->native_handle();
+		this->native_handle() = bmv.release();
+		return *this;
+	}
+
+#if __cpp_constexpr_dynamic_alloc >= 201907L
+	constexpr
+#endif
+	~overlapped()
+	{
+		delete this->native_handle();
+	}
+};
+
+}
+
+/*
+epoll::reactor drives nonblocking sockets with edge-triggered epoll where io_uring is unavailable. An operation first
+tries its system call right away. Only when that fails with EAGAIN is it parked, and the socket joins the epoll set
+with EPOLLIN|EPOLLOUT|EPOLLRDHUP|EPOLLET, so a socket that keeps up costs no epoll_ctl. An edge wakes the parked
+operation, which retries until it finishes or hits EAGAIN again.
+A read completes with what one recv returned, 0 at end of stream. A write completes once every byte has been sent.
+As with io_uring, callbacks run only from io_async_wait or io_async_peek, never inside the call that started the
+operation, so a callback that starts the next operation does not grow the stack. As with a failed CQE, a failed
+operation is completed with its negated errno, so the error reaches the operation it belongs to and never the loop.
+One read and one write may be pending on a socket at a time. Before a socket with a pending operation is closed,
+cancel(fd) drops its operations, and their callbacks are never called. When a parked operation is left behind anyway,
+it is discarded once its fd number is added to the epoll set again, so it never runs for a later socket.
+*/
+
+namespace details
+{
+
+inline constexpr std::size_t epoll_reactor_batch_size{64};
+
+struct epoll_reactor_operation
+{
+	epoll::overlapped_base* callback{};
+	std::byte* first{};
+	std::size_t size{};
+	std::size_t transferred{};
+};
+
+struct epoll_reactor_completion
+{
+	int fd;
+	epoll::overlapped_base* callback;
+	std::size_t transferred;
+	int error;
+};
+
+struct epoll_reactor_fd
+{
+	epoll_reactor_operation reader;
+	epoll_reactor_operation writer;
+};
+
+}
+
+namespace epoll
+{
+
+class reactor
+{
+	handle_pool pool{0,close_on_exec_function_invoked};
+	std::vector<details::epoll_reactor_fd> fds;
+	std::vector<details::epoll_reactor_completion> ready;
+	std::vector<details::epoll_reactor_completion> dispatching;
+
+	void complete(int fd,details::epoll_reactor_operation const& op,int error)
+	{
+		ready.push_back({fd,op.callback,op.transferred,error});
+	}
+//returns false when the socket would block
+	bool attempt_read(int fd,details::epoll_reactor_operation& op)
+	{
+		for(;;)
+		{
+			auto const r{::recv(fd,op.first,op.size,0)};
+			if(r==-1)
+			{
+				if(errno==EINTR)
+					continue;
+				if(errno==EAGAIN||errno==EWOULDBLOCK)
+					return false;
+				complete(fd,op,errno);
+				return true;
+			}
+			op.transferred=static_cast<std::size_t>(r);
+			complete(fd,op,0);
+			return true;
+		}
+	}
+	bool attempt_write(int fd,details::epoll_reactor_operation& op)
+	{
+		for(;op.transferred!=op.size;)
+		{
+			auto const r{::send(fd,op.first+op.transferred,op.size-op.transferred,MSG_NOSIGNAL)};
+			if(r==-1)
+			{
+				if(errno==EINTR)
+					continue;
+				if(errno==EAGAIN||errno==EWOULDBLOCK)
+					return false;
+				complete(fd,op,errno);
+				return true;
+			}
+			op.transferred+=static_cast<std::size_t>(r);
+		}
+		complete(fd,op,0);
+		return true;
+	}
+/*
+The kernel drops a closed fd from the epoll set. If the add succeeds, the fd number therefore belongs to a new socket,
+and whatever is still parked in its slot belonged to a closed one.
+*/
+	details::epoll_reactor_fd& park(int fd)
+	{
+		auto const index{static_cast<std::size_t>(fd)};
+		if(fds.size()<=index)
+			fds.resize(index+1);
+		epoll_event evt{EPOLLIN|EPOLLOUT|EPOLLRDHUP|EPOLLET,{.fd=fd}};
+		if(::epoll_ctl(pool.native_handle(),EPOLL_CTL_ADD,fd,std::addressof(evt))==-1)
+		{
+			if(errno!=EEXIST)
+				throw_posix_error();
+		}
+		else
+			fds[index]={};
+		return fds[index];
+	}
+	void on_event(int fd,std::uint32_t evs)
+	{
+		auto const index{static_cast<std::size_t>(fd)};
+		if(fds.size()<=index)
+			return;
+		auto& st{fds[index]};
+		if(st.reader.callback&&(evs&(EPOLLIN|EPOLLRDHUP|EPOLLHUP|EPOLLERR))&&attempt_read(fd,st.reader))
+			st.reader={};
+		if(st.writer.callback&&(evs&(EPOLLOUT|EPOLLHUP|EPOLLERR))&&attempt_write(fd,st.writer))
+			st.writer={};
+	}
+	std::size_t dispatch()
+	{
+		std::swap(ready,dispatching);
+		for(auto const& e : dispatching)
+		{
+			if(!e.callback)
+				continue;
+			if(e.error)
+				e.callback->invoke(-static_cast<std::ptrdiff_t>(e.error));
+			else
+				e.callback->invoke(static_cast<std::ptrdiff_t>(e.transferred));
+		}
+		std::size_t const n{dispatching.size()};
+		dispatching.clear();
+		return n;
+	}
+public:
+	using native_handle_type = int;
+	reactor()=default;
+	reactor(reactor const&)=delete;
+	reactor& operator=(reactor const&)=delete;
+	int native_handle() const noexcept
+	{
+		return pool.native_handle();
+	}
+	void start_read(int fd,std::byte* first,std::size_t size,overlapped_observer callback)
+	{
+		details::epoll_reactor_operation op{callback.native_handle(),first,size};
+		if(!attempt_read(fd,op))
+			park(fd).reader=op;
+	}
+	void start_write(int fd,std::byte const* first,std::size_t size,overlapped_observer callback)
+	{
+		details::epoll_reactor_operation op{callback.native_handle(),const_cast<std::byte*>(first),size};
+		if(!attempt_write(fd,op))
+			park(fd).writer=op;
+	}
+//drops the operations of fd, parked or completed but not yet dispatched. Returns how many were dropped.
+	std::size_t cancel(int fd) noexcept
+	{
+		std::size_t n{};
+		auto const index{static_cast<std::size_t>(fd)};
+		if(index<fds.size())
+		{
+			auto& st{fds[index]};
+			n=(st.reader.callback!=nullptr)+(st.writer.callback!=nullptr);
+			st={};
+			epoll_event evt{};
+			::epoll_ctl(pool.native_handle(),EPOLL_CTL_DEL,fd,std::addressof(evt));
+		}
+		auto const old_size{ready.size()};
+		std::erase_if(ready,[fd](details::epoll_reactor_completion const& e) noexcept
+		{
+			return e.fd==fd;
+		});
+		n+=old_size-ready.size();
+//a callback of the batch being dispatched may cancel another operation of that batch
+		for(auto& e : dispatching)
+			if(e.fd==fd&&e.callback)
+			{
+				e.callback=nullptr;
+				++n;
+			}
+		return n;
+	}
+//timeout in milliseconds, -1 blocks. Returns how many completions were dispatched.
+	std::size_t run_once(int timeout)
+	{
+		if(!ready.empty())
+			timeout=0;
+		epoll_event evs[details::epoll_reactor_batch_size];
+		int n{::epoll_wait(pool.native_handle(),evs,static_cast<int>(details::epoll_reactor_batch_size),timeout)};
+		if(n==-1)
+		{
+			if(errno!=EINTR)
+				throw_posix_error();
+			n=0;
+		}
+		for(int i{};i!=n;++i)
+			on_event(evs[i].data.fd,evs[i].events);
+		return dispatch();
+	}
+};
+
+template<std::contiguous_iterator Iter>
+inline void async_read_callback(reactor& r,basic_socket<true>& soc,Iter begin,Iter end,
+	overlapped_observer callback,std::ptrdiff_t=0)
+{
+	r.start_read(soc.native_handle(),reinterpret_cast<std::byte*>(std::to_address(begin)),
+		static_cast<std::size_t>(end-begin)*sizeof(*begin),callback);
+}
+
+template<std::contiguous_iterator Iter>
+inline void async_write_callback(reactor& r,basic_socket<true>& soc,Iter begin,Iter end,
+	overlapped_observer callback,std::ptrdiff_t=0)
+{
+	r.start_write(soc.native_handle(),reinterpret_cast<std::byte const*>(std::to_address(begin)),
+		static_cast<std::size_t>(end-begin)*sizeof(*begin),callback);
+}
+
+inline std::size_t cancel(reactor& r,basic_socket<true>& soc) noexcept
+{
+	return r.cancel(soc.native_handle());
+}
+
+//blocks until at least one operation completes
+inline void io_async_wait(reactor& r)
+{
+	while(!r.run_once(-1));
+}
+
+inline bool io_async_peek(reactor& r)
+{
+	return r.run_once(0)!=0;
+}
+
+}
+
+inline constexpr io_type_t<epoll::reactor> async_scheduler_type(basic_socket<true>&)
+{
+	return io_type_t<epoll::reactor>{};
+}
+
+inline constexpr io_type_t<epoll::overlapped> async_overlapped_type(basic_socket<true>&)
+{
+	return io_type_t<epoll::overlapped>{};
 }
 
 }
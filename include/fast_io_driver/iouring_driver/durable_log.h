@@ -0,0 +1,270 @@
+#pragma once
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<future>
+#include<functional>
+
+namespace fast_io
+{
+
+/*
+basic_io_uring_durable_log is an append-only stream for write-ahead logs. It becomes durable through group commit.
+Producers on any thread append records into the open group. A committer thread takes the whole group and issues one
+WRITE linked (IOSQE_IO_LINK) to an FSYNC with IORING_FSYNC_DATASYNC in a single submission. While that commit is
+in flight, the next group fills up. When the fdatasync returns, every producer of the group is told that its bytes
+are durable: a future from append() becomes ready, or a callback from append(first,last,func) is called with 0.
+On failure the future holds a posix_error and the callback gets the errno. Once a commit has failed, what reached the
+disk is unknown, so the error is latched and every later group fails with it too.
+Callbacks run on the committer thread and must not throw.
+write() appends without waiting. flush() waits until everything appended before it is durable.
+An open group holds at most group_limit bytes, 64 MiB by default. An append that would overflow it blocks until the
+committer takes the group, unless the group is empty, so a single larger record still goes through.
+*/
+
+template<typename Ohandler>
+class basic_io_uring_durable_log
+{
+public:
+	using native_handle_type = Ohandler;
+	using char_type = typename Ohandler::char_type;
+	static inline constexpr std::size_t default_group_limit{static_cast<std::size_t>(64)<<20};
+private:
+	struct group
+	{
+		std::vector<char_type> data;
+		std::vector<std::promise<void>> promises;
+		std::vector<std::function<void(int)>> callbacks;
+		bool empty() const noexcept
+		{
+			return data.empty()&&promises.empty()&&callbacks.empty();
+		}
+		void clear() noexcept
+		{
+			data.clear();
+			promises.clear();
+			callbacks.clear();
+		}
+	};
+	Ohandler oh;
+	io_uring ring;
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::condition_variable space;
+	group open_group;
+	group committing;
+	std::size_t group_limit{default_group_limit};
+	int latched_error{};
+	bool stopping{};
+	std::jthread committer;
+
+//WRITE linked to FSYNC(DATASYNC). A short write cancels the fsync, so the rest is submitted again.
+//A write is capped at what read/write transfer at most, and the fsync is only linked to the last one.
+	int commit_group(group& g) noexcept
+	{
+		constexpr std::size_t write_max{0x7ffff000};
+		int const fd{static_cast<basic_posix_io_observer<char_type>>(oh).fd};
+		auto const first{reinterpret_cast<std::byte const*>(g.data.data())};
+		std::size_t const bytes{g.data.size()*sizeof(char_type)};
+		std::size_t written{};
+		for(;;)
+		{
+			unsigned count{};
+			bool const with_write{written!=bytes};
+			bool with_fsync{true};
+			if(with_write)
+			{
+				std::size_t chunk{bytes-written};
+				if(write_max<chunk)
+				{
+					chunk=write_max;
+					with_fsync=false;
+				}
+				auto sqe{io_uring_get_sqe(ring.native_handle())};
+				io_uring_prep_write(sqe,fd,first+written,static_cast<unsigned>(chunk),static_cast<std::uint64_t>(-1));
+				if(with_fsync)
+					io_uring_sqe_set_flags(sqe,IOSQE_IO_LINK);
+				io_uring_sqe_set_data64(sqe,0);
+				++count;
+			}
+			if(with_fsync)
+			{
+				auto sqe{io_uring_get_sqe(ring.native_handle())};
+				io_uring_prep_fsync(sqe,fd,IORING_FSYNC_DATASYNC);
+				io_uring_sqe_set_data64(sqe,1);
+				++count;
+			}
+			int ret{io_uring_submit_and_wait(ring.native_handle(),count)};
+			if(ret<0&&ret!=-EINTR)
+				return -ret;
+			std::int32_t write_result{},fsync_result{};
+			for(unsigned i{};i!=count;++i)
+			{
+				io_uring_cqe* cqe{};
+				ret=io_uring_wait_cqe(ring.native_handle(),std::addressof(cqe));
+				if(ret<0)
+					return -ret;
+				(io_uring_cqe_get_data64(cqe)?fsync_result:write_result)=cqe->res;
+				io_uring_cqe_seen(ring.native_handle(),cqe);
+			}
+			if(with_write)
+			{
+				if(write_result<0)
+					return -write_result;
+				written+=static_cast<std::size_t>(write_result);
+				if(written!=bytes)
+				{
+					if(write_result==0)
+						return EIO;
+					continue;
+				}
+			}
+			if(fsync_result<0)
+				return -fsync_result;
+			return 0;
+		}
+	}
+	static void complete(group& g,int errc) noexcept
+	{
+		if(errc&&!g.promises.empty())
+		{
+#ifdef __cpp_exceptions
+			std::exception_ptr eptr;
+			try
+			{
+				throw_posix_error(errc);
+			}
+			catch(...)
+			{
+				eptr=std::current_exception();
+			}
+			for(auto& e : g.promises)
+				e.set_exception(eptr);
+#else
+			fast_terminate();
+#endif
+		}
+		else
+		{
+			for(auto& e : g.promises)
+				e.set_value();
+		}
+		for(auto& e : g.callbacks)
+			e(errc);
+	}
+	void commit_loop() noexcept
+	{
+		for(;;)
+		{
+			{
+				std::unique_lock lk{mtx};
+				cv.wait(lk,[this]{return stopping||!open_group.empty();});
+				if(open_group.empty())
+					return;
+				std::swap(open_group,committing);
+			}
+			space.notify_all();
+			if(!latched_error)
+				latched_error=commit_group(committing);
+			complete(committing,latched_error);
+			committing.clear();
+		}
+	}
+	template<std::contiguous_iterator Iter>
+	void append_impl(std::unique_lock<std::mutex>& lk,Iter begin,Iter end)
+	{
+		auto const b{reinterpret_cast<char_type const*>(std::to_address(begin))};
+		auto const e{reinterpret_cast<char_type const*>(std::to_address(end))};
+		std::size_t const n{static_cast<std::size_t>(e-b)*sizeof(char_type)};
+		space.wait(lk,[&]{return open_group.data.empty()||open_group.data.size()*sizeof(char_type)+n<=group_limit;});
+		open_group.data.insert(open_group.data.end(),b,e);
+	}
+	void start()
+	{
+		committer=std::jthread([this]{commit_loop();});
+	}
+public:
+	template<typename... Args>
+	requires std::constructible_from<Ohandler,Args...>
+	basic_io_uring_durable_log(Args&&... args):oh(std::forward<Args>(args)...),ring(native_interface,4,0)
+	{
+		start();
+	}
+	basic_io_uring_durable_log(basic_io_uring_durable_log const&)=delete;
+	basic_io_uring_durable_log& operator=(basic_io_uring_durable_log const&)=delete;
+//everything appended before destruction is committed first
+	~basic_io_uring_durable_log()
+	{
+		{
+			std::lock_guard lg{mtx};
+			stopping=true;
+		}
+		cv.notify_one();
+		committer.join();
+	}
+	inline constexpr auto& native_handle() noexcept
+	{
+		return oh;
+	}
+	void set_group_limit(std::size_t bytes) noexcept
+	{
+		{
+			std::lock_guard lg{mtx};
+			group_limit=bytes;
+		}
+		space.notify_all();
+	}
+	template<std::contiguous_iterator Iter>
+	std::future<void> append(Iter begin,Iter end)
+	{
+		std::future<void> fut;
+		{
+			std::unique_lock lk{mtx};
+			append_impl(lk,begin,end);
+			open_group.promises.emplace_back();
+			fut=open_group.promises.back().get_future();
+		}
+		cv.notify_one();
+		return fut;
+	}
+	template<std::contiguous_iterator Iter,typename Func>
+	requires std::invocable<Func&,int>
+	void append(Iter begin,Iter end,Func&& func)
+	{
+		{
+			std::unique_lock lk{mtx};
+			append_impl(lk,begin,end);
+			open_group.callbacks.emplace_back(std::forward<Func>(func));
+		}
+		cv.notify_one();
+	}
+	template<std::contiguous_iterator Iter>
+	void write(Iter begin,Iter end)
+	{
+		{
+			std::unique_lock lk{mtx};
+			append_impl(lk,begin,end);
+		}
+		cv.notify_one();
+	}
+};
+
+template<typename Ohandler,std::contiguous_iterator Iter>
+inline void write(basic_io_uring_durable_log<Ohandler>& log,Iter begin,Iter end)
+{
+	log.write(begin,end);
+}
+
+template<typename Ohandler>
+inline void flush(basic_io_uring_durable_log<Ohandler>& log)
+{
+	typename Ohandler::char_type const* p{};
+	log.append(p,p).get();
+}
+
+template<std::integral char_type>
+using basic_io_uring_durable_log_file = basic_io_uring_durable_log<basic_file_wrapper<basic_native_file<char_type>,open_mode::app|open_mode::binary>>;
+
+using io_uring_durable_log_file = basic_io_uring_durable_log_file<char>;
+
+}
@@ -4,6 +4,20 @@
 namespace fast_io
 {
 
+/*
+io_uring_options builds a ring with IORING_SETUP_SQPOLL. A kernel thread then polls the submission queue, so
+steady state I/O needs no system call at all. The poller sleeps after sq_thread_idle milliseconds without work and
+liburing wakes it on the next submit. sq_thread_cpu pins the poller to one CPU when it is not negative.
+*/
+struct io_uring_options
+{
+	unsigned entries{64};
+	unsigned flags{};
+	bool sqpoll{};
+	std::uint32_t sq_thread_idle{1000};
+	int sq_thread_cpu{-1};
+};
+
 class io_uring:public io_uring_observer
 {
 public:
@@ -19,6 +33,26 @@ public:
 			throw_posix_error();
 		queue.release();
 	}
+	explicit io_uring(io_uring_options const& options):io_uring_observer{new ::io_uring}
+	{
+		io_uring queue(this->native_handle());
+		::io_uring_params params{};
+		params.flags=options.flags;
+		if(options.sqpoll)
+		{
+			params.flags|=IORING_SETUP_SQPOLL;
+			params.sq_thread_idle=options.sq_thread_idle;
+			if(0<=options.sq_thread_cpu)
+			{
+				params.flags|=IORING_SETUP_SQ_AFF;
+				params.sq_thread_cpu=static_cast<std::uint32_t>(options.sq_thread_cpu);
+			}
+		}
+		int const ret{io_uring_queue_init_params(options.entries,this->native_handle(),std::addressof(params))};
+		if(ret<0)[[unlikely]]
+			throw_posix_error(-ret);
+		queue.release();
+	}
 	io_uring(io_async_t):io_uring(native_interface,64,0){}
 	io_uring(io_uring const&)=delete;
 	io_uring& operator=(io_uring const&)=delete;
@@ -44,8 +78,222 @@ public:
 
 inline void submit(io_uring_observer ring)
 {
-	if(io_uring_submit(ring.ring)<0)
-		throw_posix_error();
+	int const ret{io_uring_submit(ring.ring)};
+	if(ret<0)
+		throw_posix_error(-ret);
 }
 
+//SQEs queued by the async callbacks that the kernel has not seen yet
+inline std::size_t pending_submissions(io_uring_observer ring) noexcept
+{
+	return io_uring_sq_ready(ring.ring);
+}
+
+/*
+io_uring_fixed_buffers allocates count buffers of buffer_size bytes and registers them with a ring. READ_FIXED and
+WRITE_FIXED into them skip pinning the pages on every operation. acquire() hands out a free buffer, or an empty one
+once all of them are in use. A ring holds one buffer table at a time.
+*/
+
+struct io_uring_fixed_buffer
+{
+	std::byte* data{};
+	std::size_t size{};
+	int index{-1};
+	constexpr explicit operator bool() const noexcept
+	{
+		return data!=nullptr;
+	}
+//the part [offset,offset+n) of the buffer. It keeps the index of the registered buffer.
+	constexpr io_uring_fixed_buffer subspan(std::size_t offset,std::size_t n) const noexcept
+	{
+		return {data+offset,n,index};
+	}
+};
+
+class io_uring_fixed_buffers
+{
+	io_uring_observer ring;
+	std::byte* storage{};
+	std::size_t buffer_size{};
+	std::size_t buffer_count{};
+	std::vector<int> free_list;
+	void close_impl() noexcept
+	{
+		if(storage)
+			io_aligned_allocator<std::byte>{}.deallocate(storage,buffer_size*buffer_count);
+	}
+public:
+	io_uring_fixed_buffers(io_uring_observer r,std::size_t count,std::size_t size):ring(r),buffer_size(size),buffer_count(count)
+	{
+		storage=io_aligned_allocator<std::byte>{}.allocate(buffer_size*buffer_count);
+#ifdef __cpp_exceptions
+		try
+		{
+#endif
+			std::vector<io_scatter_t> iovecs(buffer_count);
+			for(std::size_t i{};i!=buffer_count;++i)
+				iovecs[i]={storage+i*buffer_size,buffer_size};
+			int const ret{io_uring_register_buffers(ring.ring,reinterpret_cast<details::iovec_may_alias const*>(iovecs.data()),static_cast<unsigned>(buffer_count))};
+			if(ret<0)
+				throw_posix_error(-ret);
+			free_list.reserve(buffer_count);
+			for(std::size_t i{buffer_count};i--;)
+				free_list.push_back(static_cast<int>(i));
+#ifdef __cpp_exceptions
+		}
+		catch(...)
+		{
+			close_impl();
+			throw;
+		}
+#endif
+	}
+	io_uring_fixed_buffers(io_uring_fixed_buffers const&)=delete;
+	io_uring_fixed_buffers& operator=(io_uring_fixed_buffers const&)=delete;
+	~io_uring_fixed_buffers()
+	{
+		io_uring_unregister_buffers(ring.ring);
+		close_impl();
+	}
+	std::size_t size() const noexcept
+	{
+		return buffer_count;
+	}
+	std::size_t available() const noexcept
+	{
+		return free_list.size();
+	}
+	io_uring_fixed_buffer operator[](std::size_t index) const noexcept
+	{
+		return {storage+index*buffer_size,buffer_size,static_cast<int>(index)};
+	}
+	io_uring_fixed_buffer acquire() noexcept
+	{
+		if(free_list.empty())
+			return {};
+		int const index{free_list.back()};
+		free_list.pop_back();
+		return (*this)[static_cast<std::size_t>(index)];
+	}
+	void release(io_uring_fixed_buffer buffer) noexcept
+	{
+		free_list.push_back(buffer.index);
+	}
+};
+
+/*
+io_uring_fixed_files keeps a sparse table of registered files. An SQE that refers to a slot with IOSQE_FIXED_FILE
+saves the fd lookup and the reference counting on the file. add(fd) fills a free slot, remove gives it back.
+The ring does not own the fds.
+*/
+
+struct io_uring_fixed_file
+{
+	int index{-1};
+};
+
+class io_uring_fixed_files
+{
+	io_uring_observer ring;
+	std::vector<int> free_list;
+public:
+	io_uring_fixed_files(io_uring_observer r,std::size_t slots):ring(r)
+	{
+		std::vector<int> fds(slots,-1);
+		int const ret{io_uring_register_files(ring.ring,fds.data(),static_cast<unsigned>(slots))};
+		if(ret<0)
+			throw_posix_error(-ret);
+		free_list.reserve(slots);
+		for(std::size_t i{slots};i--;)
+			free_list.push_back(static_cast<int>(i));
+	}
+	io_uring_fixed_files(io_uring_fixed_files const&)=delete;
+	io_uring_fixed_files& operator=(io_uring_fixed_files const&)=delete;
+	~io_uring_fixed_files()
+	{
+		io_uring_unregister_files(ring.ring);
+	}
+	std::size_t available() const noexcept
+	{
+		return free_list.size();
+	}
+	template<std::integral char_type>
+	io_uring_fixed_file add(basic_posix_io_observer<char_type> piob)
+	{
+		if(free_list.empty())
+			throw_posix_error(ENFILE);
+		int const index{free_list.back()};
+		int const ret{io_uring_register_files_update(ring.ring,static_cast<unsigned>(index),std::addressof(piob.fd),1)};
+		if(ret<0)
+			throw_posix_error(-ret);
+		free_list.pop_back();
+		return {index};
+	}
+	void remove(io_uring_fixed_file file) noexcept
+	{
+		int const empty{-1};
+		io_uring_register_files_update(ring.ring,static_cast<unsigned>(file.index),std::addressof(empty),1);
+		free_list.push_back(file.index);
+	}
+};
+
+/*
+io_uring_buffer_ring is a ring of provided buffers (IORING_REGISTER_PBUF_RING) in buffer group group_id(). An
+operation with IOSQE_BUFFER_SELECT takes a buffer from the ring only once data arrives, so idle sockets hold no
+receive buffer. The CQE carries the id of the buffer it picked, and recycle(id) hands the buffer back.
+count must be a power of two.
+*/
+
+class io_uring_buffer_ring
+{
+	io_uring_observer ring;
+	::io_uring_buf_ring* br{};
+	std::byte* storage{};
+	unsigned buffer_count{};
+	std::uint32_t buffer_size{};
+	std::uint16_t group{};
+public:
+	io_uring_buffer_ring(io_uring_observer r,unsigned count,std::uint32_t size,std::uint16_t group_id=0):
+		ring(r),buffer_count(count),buffer_size(size),group(group_id)
+	{
+		storage=io_aligned_allocator<std::byte>{}.allocate(static_cast<std::size_t>(buffer_count)*buffer_size);
+		int ret{};
+		br=io_uring_setup_buf_ring(ring.ring,buffer_count,group,0,std::addressof(ret));
+		if(br==nullptr)
+		{
+			io_aligned_allocator<std::byte>{}.deallocate(storage,static_cast<std::size_t>(buffer_count)*buffer_size);
+			throw_posix_error(-ret);
+		}
+		int const mask{io_uring_buf_ring_mask(buffer_count)};
+		for(unsigned i{};i!=buffer_count;++i)
+			io_uring_buf_ring_add(br,storage+static_cast<std::size_t>(i)*buffer_size,buffer_size,static_cast<unsigned short>(i),mask,static_cast<int>(i));
+		io_uring_buf_ring_advance(br,static_cast<int>(buffer_count));
+	}
+	io_uring_buffer_ring(io_uring_buffer_ring const&)=delete;
+	io_uring_buffer_ring& operator=(io_uring_buffer_ring const&)=delete;
+	~io_uring_buffer_ring()
+	{
+		io_uring_free_buf_ring(ring.ring,br,buffer_count,group);
+		io_aligned_allocator<std::byte>{}.deallocate(storage,static_cast<std::size_t>(buffer_count)*buffer_size);
+	}
+	std::uint16_t group_id() const noexcept
+	{
+		return group;
+	}
+	std::uint32_t size() const noexcept
+	{
+		return buffer_size;
+	}
+	std::byte* operator[](unsigned id) const noexcept
+	{
+		return storage+static_cast<std::size_t>(id)*buffer_size;
+	}
+	void recycle(unsigned id) noexcept
+	{
+		io_uring_buf_ring_add(br,(*this)[id],buffer_size,static_cast<unsigned short>(id),io_uring_buf_ring_mask(buffer_count),0);
+		io_uring_buf_ring_advance(br,1);
+	}
+};
+
 }
@@ -3,13 +3,14 @@
 namespace fast_io
 {
 
+//invoke gets the result of the CQE: the byte count, or a negated errno when the operation failed
 class io_uring_overlapped_base
 {
 public:
 #if __cpp_constexpr >= 201907L
 	constexpr
 #endif
-	virtual void invoke(std::size_t) noexcept = 0;
+	virtual void invoke(std::ptrdiff_t) noexcept = 0;
 #if __cpp_constexpr >= 201907L
 	constexpr
 #endif
@@ -27,7 +28,7 @@ public:
 #if __cpp_constexpr >= 201907L
 	constexpr
 #endif
-	void invoke(std::size_t res) noexcept override
+	void invoke(std::ptrdiff_t res) noexcept override
 	{
 		callback(res);
 	}
@@ -41,7 +42,7 @@ public:
 #if __cpp_constexpr >= 201907L
 	constexpr
 #endif
-	void operator()(std::size_t res) noexcept
+	void operator()(std::ptrdiff_t res) noexcept
 	{
 		handle->invoke(res);
 	}
@@ -65,6 +66,9 @@ class io_uring_overlapped:public io_uring_overlapped_observer
 {
 public:
 	using native_handle_type = io_uring_overlapped_base*;
+	using observer_type = io_uring_overlapped_observer;
+	template<typename T>
+	using derived_type = io_uring_overlapped_derived<T>;
 	constexpr io_uring_overlapped()=default;
 	constexpr io_uring_overlapped(native_handle_type hd):io_uring_overlapped_observer{hd}{}
 
@@ -107,4 +111,27 @@ public:
 	}
 };
 
+/*
+io_uring_completion_base is for operations whose CQE flags matter, such as multishot operations and buffer selection.
+complete gets the raw result, errors included, and the flags. The reaper tells it apart from io_uring_overlapped_base
+by the low bit that details::io_uring_completion_user_data sets in user_data.
+*/
+class io_uring_completion_base
+{
+public:
+	virtual void complete(std::int32_t res,std::uint32_t flags) noexcept = 0;
+protected:
+	~io_uring_completion_base()=default;
+};
+
+namespace details
+{
+
+inline void* io_uring_completion_user_data(io_uring_completion_base* completion) noexcept
+{
+	return reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(completion)|1u);
+}
+
+}
+
 }
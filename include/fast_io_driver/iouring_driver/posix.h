@@ -3,6 +3,55 @@
 namespace fast_io
 {
 
+namespace details
+{
+
+inline ::io_uring_sqe* io_uring_get_sqe_or_submit(io_uring_observer ring)
+{
+	auto sqe{io_uring_get_sqe(ring.ring)};
+	for(;sqe==nullptr;sqe=io_uring_get_sqe(ring.ring))
+		submit(ring);
+	return sqe;
+}
+
+template<std::integral char_type>
+inline constexpr int io_uring_sqe_fd(basic_posix_io_observer<char_type> piob) noexcept
+{
+	return piob.fd;
+}
+
+inline constexpr int io_uring_sqe_fd(io_uring_fixed_file file) noexcept
+{
+	return file.index;
+}
+
+template<std::integral char_type>
+inline constexpr unsigned io_uring_sqe_file_flags(basic_posix_io_observer<char_type>) noexcept
+{
+	return 0;
+}
+
+inline constexpr unsigned io_uring_sqe_file_flags(io_uring_fixed_file) noexcept
+{
+	return IOSQE_FIXED_FILE;
+}
+
+template<typename T>
+concept io_uring_sqe_target = requires(T t)
+{
+	io_uring_sqe_fd(t);
+	io_uring_sqe_file_flags(t);
+};
+
+}
+
+/*
+The callbacks only queue their SQEs. The queue goes to the kernel in one io_uring_enter when the scheduler waits
+or peeks for completions, when the submission queue is full, or when submit(ring) is called. A loop that issues many
+operations per turn therefore pays for one system call, and none at all on an SQPOLL ring whose poller is awake.
+The span of a scatter callback must stay alive until the queue is submitted.
+*/
+
 template<std::integral char_type>
 inline constexpr io_type_t<io_uring_observer> async_scheduler_type(basic_posix_io_observer<char_type>)
 {
@@ -19,9 +68,7 @@ template<std::integral char_type>
 inline void async_scatter_write_callback(io_uring_observer ring,basic_posix_io_observer<char_type> piob,
 		std::span<io_scatter_t const> span,io_uring_overlapped_observer callback,std::ptrdiff_t offset=0)
 {
-	auto sqe{io_uring_get_sqe(ring.ring)};
-	for(;sqe==nullptr;sqe=io_uring_get_sqe(ring.ring))
-		submit(ring);
+	auto sqe{details::io_uring_get_sqe_or_submit(ring)};
 	io_uring_prep_writev(sqe,piob.fd,reinterpret_cast<details::iovec_may_alias const*>(span.data()),span.size(),offset);
 	io_uring_sqe_set_data(sqe,callback.native_handle());
 }
@@ -30,14 +77,9 @@ template<std::integral char_type,std::contiguous_iterator Iter>
 inline void async_write_callback(io_uring_observer ring, basic_posix_io_observer<char_type> piob,
 	Iter begin,Iter end,io_uring_overlapped_observer callback,std::ptrdiff_t offset=0)
 {
-	auto sqe{io_uring_get_sqe(ring.ring)};
-	for(;sqe==nullptr;sqe=io_uring_get_sqe(ring.ring))
-		submit(ring);
-	fast_io::io_scatter_t const sct{const_cast<void*>(static_cast<void const*>(std::to_address(begin))),(end-begin)*sizeof(*begin)};
-	io_uring_prep_writev(sqe,piob.fd,reinterpret_cast<details::iovec_may_alias const*>(std::addressof(sct)),1,offset);
+	auto sqe{details::io_uring_get_sqe_or_submit(ring)};
+	io_uring_prep_write(sqe,piob.fd,std::to_address(begin),static_cast<unsigned>((end-begin)*sizeof(*begin)),offset);
 	io_uring_sqe_set_data(sqe,callback.native_handle());
-	if(io_uring_submit(ring.ring)<0)
-		throw_posix_error();
 }
 
 
@@ -45,9 +87,7 @@ template<std::integral char_type>
 inline void async_scatter_read_callback(io_uring_observer ring,basic_posix_io_observer<char_type> piob,
 		std::span<io_scatter_t const> span,io_uring_overlapped_observer callback,std::ptrdiff_t offset=0)
 {
-	auto sqe{io_uring_get_sqe(ring.ring)};
-	for(;sqe==nullptr;sqe=io_uring_get_sqe(ring.ring))
-		submit(ring);
+	auto sqe{details::io_uring_get_sqe_or_submit(ring)};
 	io_uring_prep_readv(sqe,piob.fd,reinterpret_cast<details::iovec_may_alias const*>(span.data()),span.size(),offset);
 	io_uring_sqe_set_data(sqe,callback.native_handle());
 }
@@ -56,15 +96,56 @@ template<std::integral char_type,std::contiguous_iterator Iter>
 inline void async_read_callback(io_uring_observer ring, basic_posix_io_observer<char_type> piob,
 	Iter begin,Iter end,io_uring_overlapped_observer callback,std::ptrdiff_t offset=0)
 {
-	auto sqe{io_uring_get_sqe(ring.ring)};
-	for(;sqe==nullptr;sqe=io_uring_get_sqe(ring.ring))
-		submit(ring);
-	fast_io::io_scatter_t const sct{static_cast<void*>(std::to_address(begin)),(end-begin)*sizeof(*begin)};
-	io_uring_prep_readv(sqe,piob.fd,reinterpret_cast<details::iovec_may_alias const*>(std::addressof(sct)),1,offset);
+	auto sqe{details::io_uring_get_sqe_or_submit(ring)};
+	io_uring_prep_read(sqe,piob.fd,std::to_address(begin),static_cast<unsigned>((end-begin)*sizeof(*begin)),offset);
+	io_uring_sqe_set_data(sqe,callback.native_handle());
+}
+
+/*
+Fixed variants: an io_uring_fixed_file from io_uring_fixed_files stands in for the fd, and an io_uring_fixed_buffer
+from io_uring_fixed_buffers makes the operation READ_FIXED or WRITE_FIXED.
+*/
+
+template<std::contiguous_iterator Iter>
+inline void async_write_callback(io_uring_observer ring,io_uring_fixed_file file,
+	Iter begin,Iter end,io_uring_overlapped_observer callback,std::ptrdiff_t offset=0)
+{
+	auto sqe{details::io_uring_get_sqe_or_submit(ring)};
+	io_uring_prep_write(sqe,file.index,std::to_address(begin),static_cast<unsigned>((end-begin)*sizeof(*begin)),offset);
+	io_uring_sqe_set_flags(sqe,IOSQE_FIXED_FILE);
+	io_uring_sqe_set_data(sqe,callback.native_handle());
+}
+
+template<std::contiguous_iterator Iter>
+inline void async_read_callback(io_uring_observer ring,io_uring_fixed_file file,
+	Iter begin,Iter end,io_uring_overlapped_observer callback,std::ptrdiff_t offset=0)
+{
+	auto sqe{details::io_uring_get_sqe_or_submit(ring)};
+	io_uring_prep_read(sqe,file.index,std::to_address(begin),static_cast<unsigned>((end-begin)*sizeof(*begin)),offset);
+	io_uring_sqe_set_flags(sqe,IOSQE_FIXED_FILE);
 	io_uring_sqe_set_data(sqe,callback.native_handle());
-	if(io_uring_submit(ring.ring)<0)
-		throw_posix_error();
 }
 
+template<typename T>
+requires details::io_uring_sqe_target<T>
+inline void async_write_callback(io_uring_observer ring,T target,
+	io_uring_fixed_buffer buffer,io_uring_overlapped_observer callback,std::ptrdiff_t offset=0)
+{
+	auto sqe{details::io_uring_get_sqe_or_submit(ring)};
+	io_uring_prep_write_fixed(sqe,details::io_uring_sqe_fd(target),buffer.data,static_cast<unsigned>(buffer.size),offset,buffer.index);
+	io_uring_sqe_set_flags(sqe,details::io_uring_sqe_file_flags(target));
+	io_uring_sqe_set_data(sqe,callback.native_handle());
 }
 
+template<typename T>
+requires details::io_uring_sqe_target<T>
+inline void async_read_callback(io_uring_observer ring,T target,
+	io_uring_fixed_buffer buffer,io_uring_overlapped_observer callback,std::ptrdiff_t offset=0)
+{
+	auto sqe{details::io_uring_get_sqe_or_submit(ring)};
+	io_uring_prep_read_fixed(sqe,details::io_uring_sqe_fd(target),buffer.data,static_cast<unsigned>(buffer.size),offset,buffer.index);
+	io_uring_sqe_set_flags(sqe,details::io_uring_sqe_file_flags(target));
+	io_uring_sqe_set_data(sqe,callback.native_handle());
+}
+
+}
@@ -0,0 +1,274 @@
+#pragma once
+
+namespace fast_io
+{
+
+/*
+basic_io_uring_ibuf is an input buffer that keeps reads of the next chunks in flight on its own io_uring.
+Chunk k is read from offset start+k*buffer_size while the consumer parses chunk k-1. underflow usually only swaps in
+a completed buffer. Reads use explicit offsets, so the file position of the native handle is not advanced.
+The buffers and the fd are registered with the ring when the kernel allows it, so the reads are READ_FIXED on a fixed
+file. Otherwise they are plain reads.
+*/
+
+template<input_stream Ihandler,std::size_t buffers=4,
+	std::size_t buffer_size = details::cal_buffer_size<typename Ihandler::char_type,true>(),
+	typename Allocator = io_aligned_allocator<typename Ihandler::char_type>>
+requires (random_access_stream<Ihandler>&&2<=buffers&&buffer_size!=0)
+class basic_io_uring_ibuf
+{
+public:
+	using native_handle_type = Ihandler;
+	using char_type = typename Ihandler::char_type;
+	using allocator_type = Allocator;
+	static inline constexpr std::size_t size = buffer_size;
+	static inline constexpr std::size_t buffers_size = buffers;
+	Ihandler ih;
+	io_uring ring;
+	char_type *beg{},*curr{},*end{};
+private:
+	struct slot
+	{
+		char_type* buffer{};
+		std::uintmax_t offset{};
+		std::int32_t result{};
+		bool pending{};
+	};
+	Allocator alloc;
+	std::array<slot,buffers> slots{};
+	std::size_t head{};
+	std::size_t in_flight{};
+	std::uintmax_t next_offset{};
+	bool eof{};
+	bool consuming{};
+	bool fixed_buffers{};
+	bool fixed_file{};
+
+	void prepare(slot& s)
+	{
+		auto sqe{io_uring_get_sqe(ring.native_handle())};
+		for(;sqe==nullptr;sqe=io_uring_get_sqe(ring.native_handle()))
+			submit(ring);
+		s.offset=next_offset;
+		s.result=0;
+		s.pending=true;
+		++in_flight;
+		next_offset+=buffer_size*sizeof(char_type);
+		int const fd{fixed_file?0:static_cast<basic_posix_io_observer<char_type>>(ih).fd};
+		if(fixed_buffers)
+			io_uring_prep_read_fixed(sqe,fd,s.buffer,buffer_size*sizeof(char_type),s.offset,static_cast<int>(std::addressof(s)-slots.data()));
+		else
+			io_uring_prep_read(sqe,fd,s.buffer,buffer_size*sizeof(char_type),s.offset);
+		if(fixed_file)
+			io_uring_sqe_set_flags(sqe,IOSQE_FIXED_FILE);
+		io_uring_sqe_set_data(sqe,std::addressof(s));
+	}
+	void reap_one()
+	{
+		io_uring_cqe *cqe{};
+		int ret{io_uring_wait_cqe(ring.native_handle(),std::addressof(cqe))};
+		if(ret<0)
+			throw_posix_error(-ret);
+		auto s{static_cast<slot*>(io_uring_cqe_get_data(cqe))};
+		s->result=cqe->res;
+		s->pending=false;
+		--in_flight;
+		io_uring_cqe_seen(ring.native_handle(),cqe);
+	}
+	void drain() noexcept
+	{
+		for(;in_flight;)
+		{
+			io_uring_cqe *cqe{};
+			if(io_uring_wait_cqe(ring.native_handle(),std::addressof(cqe))<0)
+				return;
+			auto s{static_cast<slot*>(io_uring_cqe_get_data(cqe))};
+			s->pending=false;
+			--in_flight;
+			io_uring_cqe_seen(ring.native_handle(),cqe);
+		}
+	}
+//slots after head were read at offsets that are no longer contiguous with the data. Reissue them.
+	void resubmit_after_head()
+	{
+		drain();
+		if(eof)
+			return;
+		for(std::size_t i{1};i!=buffers;++i)
+		{
+			std::size_t pos{head+i};
+			if(buffers<=pos)
+				pos-=buffers;
+			prepare(slots[pos]);
+		}
+		submit(ring);
+	}
+//failures only cost the fast path. The ring drops both tables when it exits.
+	void register_resources() noexcept
+	{
+		std::array<io_scatter_t,buffers> iovecs;
+		for(std::size_t i{};i!=buffers;++i)
+			iovecs[i]={slots[i].buffer,buffer_size*sizeof(char_type)};
+		fixed_buffers=0<=io_uring_register_buffers(ring.native_handle(),reinterpret_cast<details::iovec_may_alias const*>(iovecs.data()),buffers);
+		int const fd{static_cast<basic_posix_io_observer<char_type>>(ih).fd};
+		fixed_file=0<=io_uring_register_files(ring.native_handle(),std::addressof(fd),1);
+	}
+	void close_impl() noexcept
+	{
+		drain();
+		for(auto& e : slots)
+			if(e.buffer)
+				std::allocator_traits<allocator_type>::deallocate(alloc,e.buffer,buffer_size);
+	}
+public:
+	template<typename... Args>
+	requires std::constructible_from<Ihandler,Args...>
+	basic_io_uring_ibuf(Args&&... args):ih(std::forward<Args>(args)...),ring(native_interface,buffers,0)
+	{
+		next_offset=static_cast<std::uintmax_t>(seek(ih,0,seekdir::cur));
+#ifdef __cpp_exceptions
+		try
+		{
+#endif
+			for(auto& e : slots)
+				e.buffer=std::allocator_traits<allocator_type>::allocate(alloc,buffer_size);
+			register_resources();
+			for(auto& e : slots)
+				prepare(e);
+			submit(ring);
+#ifdef __cpp_exceptions
+		}
+		catch(...)
+		{
+			close_impl();
+			throw;
+		}
+#endif
+	}
+	basic_io_uring_ibuf(basic_io_uring_ibuf const&)=delete;
+	basic_io_uring_ibuf& operator=(basic_io_uring_ibuf const&)=delete;
+	~basic_io_uring_ibuf()
+	{
+		close_impl();
+	}
+	inline constexpr auto& native_handle() noexcept
+	{
+		return ih;
+	}
+	bool next_buffer()
+	{
+		if(consuming)
+		{
+			consuming=false;
+			if(!eof)
+			{
+				prepare(slots[head]);
+				submit(ring);
+			}
+			if(++head==buffers)
+				head=0;
+		}
+		auto& s{slots[head]};
+		while(s.pending)
+			reap_one();
+		if(s.result<0)
+		{
+			eof=true;
+			drain();
+			throw_posix_error(-s.result);
+		}
+		std::size_t const transferred{static_cast<std::size_t>(s.result)};
+		end=(curr=beg=s.buffer)+transferred/sizeof(char_type);
+		if(transferred==0)
+		{
+			eof=true;
+			drain();
+			return false;
+		}
+		consuming=true;
+		if(transferred!=buffer_size*sizeof(char_type))
+		{
+			next_offset=s.offset+transferred;
+			resubmit_after_head();
+		}
+		return true;
+	}
+};
+
+template<input_stream Ihandler,std::size_t buffers,std::size_t buffer_size,typename Allocator>
+[[nodiscard]] inline constexpr auto ibuffer_begin(basic_io_uring_ibuf<Ihandler,buffers,buffer_size,Allocator>& ib)
+{
+	return ib.beg;
+}
+
+template<input_stream Ihandler,std::size_t buffers,std::size_t buffer_size,typename Allocator>
+[[nodiscard]] inline constexpr auto ibuffer_curr(basic_io_uring_ibuf<Ihandler,buffers,buffer_size,Allocator>& ib)
+{
+	return ib.curr;
+}
+
+template<input_stream Ihandler,std::size_t buffers,std::size_t buffer_size,typename Allocator>
+[[nodiscard]] inline constexpr auto ibuffer_end(basic_io_uring_ibuf<Ihandler,buffers,buffer_size,Allocator>& ib)
+{
+	return ib.end;
+}
+
+template<input_stream Ihandler,std::size_t buffers,std::size_t buffer_size,typename Allocator>
+inline constexpr void ibuffer_set_curr(basic_io_uring_ibuf<Ihandler,buffers,buffer_size,Allocator>& ib,typename Ihandler::char_type* ptr)
+{
+	ib.curr=ptr;
+}
+
+template<input_stream Ihandler,std::size_t buffers,std::size_t buffer_size,typename Allocator>
+inline bool underflow(basic_io_uring_ibuf<Ihandler,buffers,buffer_size,Allocator>& ib)
+{
+	return ib.next_buffer();
+}
+
+template<input_stream Ihandler,std::size_t buffers,std::size_t buffer_size,typename Allocator,std::contiguous_iterator Iter>
+requires (write_read_punned_constraints<basic_io_uring_ibuf<Ihandler,buffers,buffer_size,Allocator>,Iter>)
+inline Iter read(basic_io_uring_ibuf<Ihandler,buffers,buffer_size,Allocator>& ib,Iter begin,Iter end)
+{
+	using char_type = typename Ihandler::char_type;
+	char_type* first;
+	char_type* last;
+	if constexpr(std::same_as<char_type,std::iter_value_t<Iter>>)
+	{
+		first=std::to_address(begin);
+		last=std::to_address(end);
+	}
+	else
+	{
+		first=reinterpret_cast<char_type*>(std::to_address(begin));
+		last=reinterpret_cast<char_type*>(std::to_address(end));
+	}
+	auto it{first};
+	for(;;)
+	{
+		std::size_t const n(last-it);
+		std::size_t const remain(ib.end-ib.curr);
+		if(n<=remain)
+		{
+			if(n)
+				memcpy(it,ib.curr,n*sizeof(char_type));
+			ib.curr+=n;
+			it=last;
+			break;
+		}
+//curr is still null before the first buffer arrives
+		if(remain)
+			memcpy(it,ib.curr,remain*sizeof(char_type));
+		it+=remain;
+		ib.curr=ib.end;
+		if(it!=first||!ib.next_buffer())
+			break;
+	}
+	return begin+(it-first)*sizeof(char_type)/sizeof(*begin);
+}
+
+template<std::integral char_type,std::size_t buffers=4>
+using basic_io_uring_ibuf_file = basic_io_uring_ibuf<input_file_wrapper<basic_native_file<char_type>>,buffers>;
+
+using io_uring_ibuf_file = basic_io_uring_ibuf_file<char>;
+
+}
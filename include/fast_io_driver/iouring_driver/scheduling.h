@@ -3,46 +3,101 @@
 namespace fast_io
 {
 
+/*
+Completions are reaped in batches. io_uring_peek_batch_cqe collects every CQE that is ready, the CQ ring is advanced
+once for the whole batch, and only then are the callbacks invoked. A callback may therefore queue new operations
+while the batch is dispatched. Every operation is completed with the signed result of its CQE, a negated errno when it
+failed, so a failure reaches the one operation it belongs to and never stops the batch. CQEs without user data, such
+as those of cancellations, are skipped.
+io_async_wait blocks for at least one completion, io_async_peek never blocks, and io_async_busy_poll spins in user
+space for a bounded time before giving up. On an SQPOLL ring the latter two need no system call at all.
+*/
+
 namespace details
 {
 
+inline constexpr unsigned io_uring_reap_batch_size{64};
+
+inline std::size_t io_uring_reap(io_uring_observer ring)
+{
+	std::size_t total{};
+	for(;;)
+	{
+		::io_uring_cqe* cqes[io_uring_reap_batch_size];
+		unsigned const n{io_uring_peek_batch_cqe(ring.ring,cqes,io_uring_reap_batch_size)};
+		if(n==0)
+			return total;
+		struct completion
+		{
+			void* data;
+			std::int32_t res;
+			std::uint32_t flags;
+		};
+		completion completions[io_uring_reap_batch_size];
+		for(unsigned i{};i!=n;++i)
+			completions[i]={io_uring_cqe_get_data(cqes[i]),cqes[i]->res,cqes[i]->flags};
+		io_uring_cq_advance(ring.ring,n);
+		for(unsigned i{};i!=n;++i)
+		{
+			auto const& e{completions[i]};
+//liburing's own wait timeouts complete with all bits set, which would pass for a tagged completion
+			if(e.data==nullptr||e.data==reinterpret_cast<void*>(LIBURING_UDATA_TIMEOUT))
+				continue;
+			auto const bits{reinterpret_cast<std::uintptr_t>(e.data)};
+			if(bits&1u)
+				reinterpret_cast<io_uring_completion_base*>(bits^1u)->complete(e.res,e.flags);
+			else
+				static_cast<io_uring_overlapped_base*>(e.data)->invoke(e.res);
+		}
+		total+=n;
+		if(n!=io_uring_reap_batch_size)
+			return total;
+	}
+}
 
-inline void deal_with_cqe(io_uring_observer ring,io_uring_cqe *cqe)
+inline void io_uring_submit_pending(io_uring_observer ring)
 {
-	if(!cqe)
-		return;
-	void* data{io_uring_cqe_get_data(cqe)};
-	std::int32_t res{cqe->res};
-	io_uring_cqe_seen(ring.ring,cqe);
-	if(res<0)
-		throw_posix_error(-res);
-	static_cast<io_uring_overlapped_base*>(data)->invoke(static_cast<std::size_t>(res));
+	if(io_uring_sq_ready(ring.ring))
+		submit(ring);
 }
 
 }
 
+//dispatch every completion that is ready without blocking. Returns how many were reaped.
+inline std::size_t io_async_reap(io_uring_observer ring)
+{
+	details::io_uring_submit_pending(ring);
+	return details::io_uring_reap(ring);
+}
 
+//the queued SQEs of this loop turn go to the kernel in the same io_uring_enter that waits for a completion
 inline void io_async_wait(io_uring_observer ring)
 {
-	io_uring_cqe *cqe{};
-	int ret{io_uring_wait_cqe(ring.ring,std::addressof(cqe))};
-	if(ret<0)
+	int ret{io_uring_submit_and_wait(ring.ring,1)};
+	if(ret<0&&ret!=-EINTR)
 		throw_posix_error(-ret);
-	details::deal_with_cqe(ring,cqe);
+	details::io_uring_reap(ring);
 }
 
 inline bool io_async_peek(io_uring_observer ring)
 {
-	io_uring_cqe *cqe{};
-	int ret{io_uring_wait_cqe(ring.ring,std::addressof(cqe))};
-	if(ret<0)
+	return io_async_reap(ring)!=0;
+}
+
+//spin on the CQ ring for at most duration. Returns how many completions were reaped, 0 on timeout.
+template<typename Rep,typename Period>
+inline std::size_t io_async_busy_poll(io_uring_observer ring,std::chrono::duration<Rep,Period> duration)
+{
+	details::io_uring_submit_pending(ring);
+	auto const deadline{std::chrono::steady_clock::now()+duration};
+	for(;;)
 	{
-		if(ret!=-EAGAIN)
-			throw_posix_error(-ret);
-		return false;
+		if(io_uring_cq_ready(ring.ring))
+			return details::io_uring_reap(ring);
+		if(deadline<=std::chrono::steady_clock::now())
+			return 0;
+		details::io_mutex_pause();
 	}
-	details::deal_with_cqe(ring,cqe);
-	return true;
 }
 
 namespace details
@@ -50,6 +105,7 @@ namespace details
 
 inline bool io_uring_io_async_wait_timeout_detail(io_uring_observer ring,__kernel_timespec ts)
 {
+	io_uring_submit_pending(ring);
 	io_uring_cqe *cqe{};
 	int ret{io_uring_wait_cqe_timeout(ring.ring,std::addressof(cqe),std::addressof(ts))};
 	if(ret<0)
@@ -58,7 +114,7 @@ inline bool io_uring_io_async_wait_timeout_detail(io_uring_observer ring,__kerne
 			throw_posix_error(-ret);
 		return false;
 	}
-	details::deal_with_cqe(ring,cqe);
+	io_uring_reap(ring);
 	return true;
 }
 
@@ -67,7 +123,6 @@ inline bool io_uring_io_async_wait_timeout_detail(io_uring_observer ring,__kerne
 template<typename Rep,typename Period>
 inline auto io_async_wait_timeout(io_uring_observer ring,std::chrono::duration<Rep,Period> duration)
 {
-	auto val{std::chrono::duration_cast<std::chrono::nanoseconds>(duration)};
 	return details::io_uring_io_async_wait_timeout_detail(ring,{std::chrono::duration_cast<std::chrono::seconds>(duration).count(),std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()%1000000000});
 }
 
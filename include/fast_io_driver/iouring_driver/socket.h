@@ -0,0 +1,425 @@
+#pragma once
+#include"../../fast_io_network.h"
+
+namespace fast_io
+{
+
+/*
+Multishot socket operations. One multishot accept SQE keeps accepting until it is cancelled, and one multishot recv
+SQE keeps receiving into buffers picked from an io_uring_buffer_ring. Every result goes to completion.complete(res,flags).
+IORING_CQE_F_MORE is clear on the last CQE of an operation. After that it has to be armed again.
+Multishot accept needs Linux 5.19, and multishot recv with a buffer ring needs Linux 6.0.
+*/
+
+template<std::integral char_type>
+inline void async_multishot_accept_callback(io_uring_observer ring,basic_posix_io_observer<char_type> listener,
+	io_uring_completion_base& completion)
+{
+	auto sqe{details::io_uring_get_sqe_or_submit(ring)};
+	io_uring_prep_multishot_accept(sqe,listener.fd,nullptr,nullptr,SOCK_CLOEXEC);
+	io_uring_sqe_set_data(sqe,details::io_uring_completion_user_data(std::addressof(completion)));
+}
+
+template<std::integral char_type>
+inline void async_multishot_recv_callback(io_uring_observer ring,basic_posix_io_observer<char_type> socket,
+	io_uring_buffer_ring& buffers,io_uring_completion_base& completion)
+{
+	auto sqe{details::io_uring_get_sqe_or_submit(ring)};
+	io_uring_prep_recv_multishot(sqe,socket.fd,nullptr,0,0);
+	io_uring_sqe_set_flags(sqe,IOSQE_BUFFER_SELECT);
+	sqe->buf_group=buffers.group_id();
+	io_uring_sqe_set_data(sqe,details::io_uring_completion_user_data(std::addressof(completion)));
+}
+
+/*
+io_uring_socket_server serves TCP connections from one io_uring. One multishot accept takes every new connection,
+and each connection keeps one multishot recv armed on a shared buffer ring. Whenever bytes arrive, the handler is
+called as func(connection,bytes). The buffer goes back to the ring when the handler returns. Output written to the
+connection is sent with IORING_OP_SEND, one send per connection in flight. Output written meanwhile is sent next.
+A connection is closed when the peer closes it, when the handler calls close() (after pending output is sent), or
+when the handler throws.
+run() blocks on the calling thread until stop() is called from any thread.
+*/
+
+struct io_uring_socket_server_options
+{
+	unsigned entries{4096};
+	unsigned buffer_count{4096};	//a power of two
+	std::uint32_t buffer_size{4096};
+	std::uint16_t buffer_group{};
+	int backlog{4096};
+};
+
+class io_uring_socket_server;
+class io_uring_connection;
+
+namespace details
+{
+
+struct io_uring_socket_event:io_uring_completion_base
+{
+	enum class kind
+	{
+		accept,recv,send,wakeup
+	};
+	io_uring_socket_server* server{};
+	io_uring_connection* connection{};
+	kind k{};
+	constexpr io_uring_socket_event(io_uring_socket_server* s,io_uring_connection* c,kind kd) noexcept:server(s),connection(c),k(kd){}
+	void complete(std::int32_t res,std::uint32_t flags) noexcept override;
+};
+
+}
+
+class io_uring_connection
+{
+public:
+	using char_type = char;
+	using native_handle_type = int;
+	int fd{-1};
+	std::vector<char> pending;
+	std::vector<char> sending;
+	std::size_t sending_offset{};
+	std::size_t index{};
+	details::io_uring_socket_event recv_event;
+	details::io_uring_socket_event send_event;
+	bool receiving{};
+	bool send_in_flight{};
+	bool closing{};
+	bool broken{};
+	bool shut{};
+	io_uring_connection(io_uring_socket_server* server,int f) noexcept:fd(f),
+		recv_event(server,this,details::io_uring_socket_event::kind::recv),
+		send_event(server,this,details::io_uring_socket_event::kind::send){}
+	io_uring_connection(io_uring_connection const&)=delete;
+	io_uring_connection& operator=(io_uring_connection const&)=delete;
+	~io_uring_connection()
+	{
+		if(fd!=-1)
+			::close(fd);
+	}
+	constexpr int native_handle() const noexcept
+	{
+		return fd;
+	}
+//close once the pending output has been sent
+	constexpr void close() noexcept
+	{
+		closing=true;
+	}
+};
+
+template<std::contiguous_iterator Iter>
+inline void write(io_uring_connection& conn,Iter begin,Iter end)
+{
+	auto const b{reinterpret_cast<char const*>(std::to_address(begin))};
+	auto const e{reinterpret_cast<char const*>(std::to_address(end))};
+	conn.pending.insert(conn.pending.end(),b,e);
+}
+
+inline constexpr void flush(io_uring_connection&) noexcept{}
+
+class io_uring_socket_server
+{
+	friend struct details::io_uring_socket_event;
+	io_uring_socket_server_options opts;
+	io_uring ring;
+	io_uring_buffer_ring buffers;
+	int listener{-1};
+	int wakeup{-1};
+	std::uint64_t wakeup_value{};
+	details::io_uring_socket_event accept_event{this,nullptr,details::io_uring_socket_event::kind::accept};
+	details::io_uring_socket_event wakeup_event{this,nullptr,details::io_uring_socket_event::kind::wakeup};
+	std::vector<std::unique_ptr<io_uring_connection>> connections;
+	void* handler{};
+	void (*handler_invoke)(void*,io_uring_connection&,std::span<char const>){};
+#ifdef __cpp_exceptions
+	std::exception_ptr error;
+#endif
+	bool accepting{};
+	bool stopping{};
+
+	void open(socket_address_storage const& stg,std::size_t address_size)
+	{
+		listener=details::event_server_listener(stg,address_size,opts.backlog);
+		if((wakeup=::eventfd(0,EFD_CLOEXEC))==-1)
+			throw_posix_error();
+	}
+	void arm_accept()
+	{
+		async_multishot_accept_callback(ring,posix_io_observer{listener},accept_event);
+		accepting=true;
+	}
+	void arm_wakeup()
+	{
+		auto sqe{details::io_uring_get_sqe_or_submit(ring)};
+		io_uring_prep_read(sqe,wakeup,std::addressof(wakeup_value),sizeof(wakeup_value),0);
+		io_uring_sqe_set_data(sqe,details::io_uring_completion_user_data(std::addressof(wakeup_event)));
+	}
+	void arm_recv(io_uring_connection& conn)
+	{
+		async_multishot_recv_callback(ring,posix_io_observer{conn.fd},buffers,conn.recv_event);
+		conn.receiving=true;
+	}
+	void send_pending(io_uring_connection& conn)
+	{
+		if(conn.send_in_flight||conn.broken)
+			return;
+		if(conn.sending.empty())
+		{
+			if(conn.pending.empty())
+				return;
+			std::swap(conn.sending,conn.pending);
+			conn.sending_offset=0;
+		}
+		auto sqe{details::io_uring_get_sqe_or_submit(ring)};
+		io_uring_prep_send(sqe,conn.fd,conn.sending.data()+conn.sending_offset,conn.sending.size()-conn.sending_offset,MSG_NOSIGNAL);
+		io_uring_sqe_set_data(sqe,details::io_uring_completion_user_data(std::addressof(conn.send_event)));
+		conn.send_in_flight=true;
+	}
+	void remove(io_uring_connection& conn) noexcept
+	{
+		std::size_t const i{conn.index};
+		if(i+1!=connections.size())
+		{
+			connections[i]=std::move(connections.back());
+			connections[i]->index=i;
+		}
+		connections.pop_back();
+	}
+//shutdown ends the multishot recv and any send. The connection goes once none of its operations is in flight.
+	void settle(io_uring_connection& conn) noexcept
+	{
+		bool const done{conn.broken||stopping||
+			(conn.closing&&!conn.send_in_flight&&conn.pending.empty()&&conn.sending.empty())};
+		if(!done)
+			return;
+		if(!conn.shut)
+		{
+			conn.shut=true;
+			::shutdown(conn.fd,SHUT_RDWR);
+		}
+		if(!conn.receiving&&!conn.send_in_flight)
+			remove(conn);
+	}
+	void add_connection(int fd)
+	{
+		std::unique_ptr<io_uring_connection> conn;
+#ifdef __cpp_exceptions
+		try
+		{
+#endif
+			connections.reserve(connections.size()+1);
+			conn.reset(new io_uring_connection(this,fd));
+#ifdef __cpp_exceptions
+		}
+		catch(...)
+		{
+			::close(fd);
+			throw;
+		}
+#endif
+		int const one{1};
+		::setsockopt(fd,IPPROTO_TCP,TCP_NODELAY,std::addressof(one),sizeof(one));
+		conn->index=connections.size();
+		connections.push_back(std::move(conn));
+		arm_recv(*connections.back());
+	}
+	void on_accept(std::int32_t res,std::uint32_t flags)
+	{
+		if(0<=res)
+		{
+			if(stopping)
+				::close(res);
+			else
+				add_connection(res);
+		}
+		if(!(flags&IORING_CQE_F_MORE))
+		{
+			accepting=false;
+			if(!stopping)
+				arm_accept();
+		}
+	}
+	void on_recv(io_uring_connection& conn,std::int32_t res,std::uint32_t flags)
+	{
+		if(flags&IORING_CQE_F_BUFFER)
+		{
+			unsigned const id{flags>>IORING_CQE_BUFFER_SHIFT};
+			if(0<res&&!conn.broken&&!conn.closing)
+			{
+#ifdef __cpp_exceptions
+				try
+				{
+#endif
+					handler_invoke(handler,conn,std::span<char const>(reinterpret_cast<char const*>(buffers[id]),static_cast<std::size_t>(res)));
+#ifdef __cpp_exceptions
+				}
+				catch(...)
+				{
+					conn.broken=true;
+				}
+#endif
+			}
+			buffers.recycle(id);
+		}
+		if(res==0||(res<0&&res!=-ENOBUFS))
+			conn.broken=true;
+		if(!(flags&IORING_CQE_F_MORE))
+		{
+			conn.receiving=false;
+			if(!conn.broken&&!conn.shut)
+				arm_recv(conn);
+		}
+		send_pending(conn);
+		settle(conn);
+	}
+	void on_send(io_uring_connection& conn,std::int32_t res)
+	{
+		conn.send_in_flight=false;
+		if(res<0)
+			conn.broken=true;
+		else
+		{
+			conn.sending_offset+=static_cast<std::size_t>(res);
+			if(conn.sending_offset==conn.sending.size())
+			{
+				conn.sending.clear();
+				conn.sending_offset=0;
+			}
+		}
+		send_pending(conn);
+		settle(conn);
+	}
+//without an SQE for the cancel, shutting the listener down ends the multishot accept as well
+	void begin_stop() noexcept
+	{
+		stopping=true;
+		if(accepting)
+		{
+#ifdef __cpp_exceptions
+			try
+			{
+#endif
+				auto sqe{details::io_uring_get_sqe_or_submit(ring)};
+				io_uring_prep_cancel64(sqe,reinterpret_cast<std::uintptr_t>(details::io_uring_completion_user_data(std::addressof(accept_event))),0);
+				io_uring_sqe_set_data(sqe,nullptr);
+#ifdef __cpp_exceptions
+			}
+			catch(...)
+			{
+				::shutdown(listener,SHUT_RDWR);
+			}
+#endif
+		}
+		for(std::size_t i{connections.size()};i--;)
+			settle(*connections[i]);
+	}
+/*
+A failure inside a completion, such as bad_alloc or a failed submit, breaks the connection it belongs to. A failure
+of the accept or the wakeup stops the server, and run() rethrows it once everything has drained.
+*/
+	void on_failure(io_uring_connection* conn) noexcept
+	{
+		if(conn)
+		{
+			conn->broken=true;
+			settle(*conn);
+			return;
+		}
+#ifdef __cpp_exceptions
+		if(!error)
+			error=std::current_exception();
+#endif
+		begin_stop();
+	}
+public:
+	template<typename addrType,std::integral U>
+	requires (!std::integral<addrType>)
+	io_uring_socket_server(addrType const& add,U port,io_uring_socket_server_options const& options={}):
+		opts(options),ring(native_interface,options.entries,0),
+		buffers(ring,options.buffer_count,options.buffer_size,options.buffer_group)
+	{
+		open(to_socket_address_storage(add,port),native_socket_address_size(add));
+	}
+	template<std::integral U>
+	explicit io_uring_socket_server(U port,io_uring_socket_server_options const& options={}):io_uring_socket_server(ipv4{},port,options){}
+	io_uring_socket_server(io_uring_socket_server const&)=delete;
+	io_uring_socket_server& operator=(io_uring_socket_server const&)=delete;
+	~io_uring_socket_server()
+	{
+		for(int fd : {listener,wakeup})
+			if(fd!=-1)
+				::close(fd);
+	}
+	io_uring_observer native_handle() noexcept
+	{
+		return ring;
+	}
+//serve until stop(). Returns once every connection is closed.
+	template<typename Func>
+	requires std::invocable<Func&,io_uring_connection&,std::span<char const>>
+	void run(Func func)
+	{
+		handler=std::addressof(func);
+		handler_invoke=[](void* h,io_uring_connection& conn,std::span<char const> bytes)
+		{
+			(*static_cast<Func*>(h))(conn,bytes);
+		};
+		stopping=false;
+		arm_wakeup();
+		arm_accept();
+		for(;!stopping||accepting||!connections.empty();)
+			io_async_wait(ring);
+#ifdef __cpp_exceptions
+		if(error)
+		{
+			auto eptr{std::move(error)};
+			error=nullptr;
+			std::rethrow_exception(eptr);
+		}
+#endif
+	}
+	void stop() noexcept
+	{
+		std::uint64_t const one{1};
+		[[maybe_unused]] auto r{::write(wakeup,std::addressof(one),sizeof(one))};
+	}
+};
+
+namespace details
+{
+
+inline void io_uring_socket_event::complete(std::int32_t res,std::uint32_t flags) noexcept
+{
+#ifdef __cpp_exceptions
+	try
+	{
+#endif
+		switch(k)
+		{
+		case kind::accept:
+			server->on_accept(res,flags);
+			break;
+		case kind::recv:
+			server->on_recv(*connection,res,flags);
+			break;
+		case kind::send:
+			server->on_send(*connection,res);
+			break;
+		case kind::wakeup:
+			server->begin_stop();
+			break;
+		}
+#ifdef __cpp_exceptions
+	}
+	catch(...)
+	{
+		server->on_failure(connection);
+	}
+#endif
+}
+
+}
+
+}
@@ -6,4 +6,7 @@
 #include"iouring_driver/overlapped.h"
 #include"iouring_driver/posix.h"
 #include"iouring_driver/scheduling.h"
+#include"iouring_driver/read_ahead.h"
+#include"iouring_driver/durable_log.h"
+#include"iouring_driver/socket.h"
 
@@ -58,6 +58,10 @@ public:
 	constexpr basic_buf_handler& operator=(basic_buf_handler const&)=delete;
 	constexpr basic_buf_handler(basic_buf_handler const&)=delete;
 	static constexpr std::size_t size = buffer_size;
+	static inline constexpr std::size_t capacity() noexcept
+	{
+		return buffer_size;
+	}
 	constexpr basic_buf_handler(basic_buf_handler&& m) noexcept:beg(m.beg),curr(m.curr),end(m.end)
 	{
 		m.end=m.curr=m.beg=nullptr;
@@ -108,6 +112,151 @@ public:
 	Allocator get_allocator() const{ return alloc;}
 };
 
+/*
+basic_adaptive_buf_handler decides its capacity at runtime instead of compile time.
+The capacity is picked when the buffer is first used with io_buffer_size_hint(handle) if the device provides one
+(st_blksize, pipe size etc.) and doubles every time a read or write bypasses the buffer because it was too small.
+obuffer_curr/obuffer_end stay plain pointers so the inline fast path is identical to basic_buf_handler.
+*/
+
+template<std::integral CharT,bool need_secure_clear=false,
+	std::size_t min_buffer_size = 4096/sizeof(CharT),
+	std::size_t max_buffer_size = 4194304/sizeof(CharT),
+	typename Allocator = io_aligned_allocator<CharT>>
+requires (min_buffer_size!=0&&min_buffer_size<=max_buffer_size)
+class basic_adaptive_buf_handler
+{
+	Allocator alloc;
+	static inline constexpr std::size_t default_buffer_size{
+		details::cal_buffer_size<CharT,true>()<min_buffer_size?min_buffer_size:
+		(max_buffer_size<details::cal_buffer_size<CharT,true>()?max_buffer_size:details::cal_buffer_size<CharT,true>())};
+	constexpr inline void deallocate_impl() noexcept
+	{
+		if(beg)[[likely]]
+		{
+			if constexpr(need_secure_clear)
+				secure_clear(beg,buffer_size*sizeof(char_type));
+			std::allocator_traits<allocator_type>::deallocate(alloc,beg,buffer_size);
+		}
+	}
+public:
+	using char_type = CharT;
+	using allocator_type = Allocator;
+	char_type *beg{},*curr{},*end{};
+	std::size_t buffer_size{default_buffer_size};
+	bool hinted{};
+	static inline constexpr std::size_t min_size = min_buffer_size;
+	static inline constexpr std::size_t max_size = max_buffer_size;
+	constexpr basic_adaptive_buf_handler()=default;
+	constexpr basic_adaptive_buf_handler& operator=(basic_adaptive_buf_handler const&)=delete;
+	constexpr basic_adaptive_buf_handler(basic_adaptive_buf_handler const&)=delete;
+	constexpr basic_adaptive_buf_handler(basic_adaptive_buf_handler&& m) noexcept:beg(m.beg),curr(m.curr),end(m.end),buffer_size(m.buffer_size),hinted(m.hinted)
+	{
+		m.end=m.curr=m.beg=nullptr;
+	}
+	constexpr basic_adaptive_buf_handler& operator=(basic_adaptive_buf_handler&& m) noexcept
+	{
+		if(std::addressof(m)!=this)[[likely]]
+		{
+			deallocate_impl();
+			beg=m.beg;
+			curr=m.curr;
+			end=m.end;
+			buffer_size=m.buffer_size;
+			hinted=m.hinted;
+			m.end=m.curr=m.beg=nullptr;
+		}
+		return *this;
+	}
+	constexpr inline std::size_t capacity() const noexcept
+	{
+		return buffer_size;
+	}
+	constexpr inline void capacity_hint(std::size_t bytes) noexcept
+	{
+		if(hinted)[[likely]]
+			return;
+		hinted=true;
+		if(beg||bytes==0)
+			return;
+		std::size_t n{bytes/sizeof(char_type)};
+		if(n<min_buffer_size)
+			n=min_buffer_size;
+		else if(max_buffer_size<n)
+			n=max_buffer_size;
+		buffer_size=n;
+	}
+	constexpr inline void observe_bypass(std::size_t n)
+	{
+		if(n<buffer_size||max_buffer_size==buffer_size)[[likely]]
+			return;
+		std::size_t new_size{max_buffer_size};
+		if(buffer_size<=(max_buffer_size>>1))
+			new_size=buffer_size<<1;
+		if(beg)
+		{
+//allocate first, so a failed allocation leaves the old buffer in place
+			auto new_buffer{std::allocator_traits<allocator_type>::allocate(alloc,new_size)};
+			deallocate_impl();
+			end=curr=beg=new_buffer;
+		}
+		buffer_size=new_size;
+	}
+	constexpr inline void init_space()
+	{
+		end=curr=beg=std::allocator_traits<allocator_type>::allocate(alloc,buffer_size);
+	}
+	constexpr inline void release()
+	{
+		deallocate_impl();
+		end=curr=beg=nullptr;
+	}
+#if __cpp_lib_is_constant_evaluated >= 201811L && __cpp_constexpr_dynamic_alloc >= 201907L
+	constexpr
+#endif
+	~basic_adaptive_buf_handler()
+	{
+		deallocate_impl();
+	}
+	Allocator get_allocator() const{ return alloc;}
+};
+
+namespace details
+{
+
+template<typename Buf,typename T>
+inline constexpr void iobuf_hint_space(Buf& buf,T& handle)
+{
+	if constexpr(requires(std::size_t n)
+	{
+		buf.capacity_hint(n);
+	})
+	{
+		if constexpr(requires()
+		{
+			{io_buffer_size_hint(handle)}->std::convertible_to<std::size_t>;
+		})
+		{
+			if(!buf.hinted)
+				buf.capacity_hint(io_buffer_size_hint(handle));
+		}
+		else
+			buf.capacity_hint(0);
+	}
+}
+
+template<typename Buf>
+inline constexpr void iobuf_observe_bypass(Buf& buf,std::size_t n)
+{
+	if constexpr(requires()
+	{
+		buf.observe_bypass(n);
+	})
+		buf.observe_bypass(n);
+}
+
+}
+
 
 template<input_stream Ihandler,typename Buf=basic_buf_handler<typename Ihandler::char_type,secure_clear_requirement_stream<Ihandler>>>
 class basic_ibuf:public ocrtp<basic_ibuf<Ihandler,Buf>>
@@ -134,8 +283,11 @@ template<input_stream Ihandler,typename Buf>
 inline constexpr bool underflow(basic_ibuf<Ihandler,Buf>& ib)
 {
 	if(ib.ibuffer.end==nullptr)
+	{
+		details::iobuf_hint_space(ib.ibuffer,ib.ih);
 		ib.ibuffer.init_space();
-	ib.ibuffer.end=read(ib.ih,ib.ibuffer.beg,ib.ibuffer.beg+Buf::size);
+	}
+	ib.ibuffer.end=read(ib.ih,ib.ibuffer.beg,ib.ibuffer.beg+ib.ibuffer.capacity());
 	ib.ibuffer.curr=ib.ibuffer.beg;
 	return ib.ibuffer.end!=ib.ibuffer.beg;
 }
@@ -144,7 +296,10 @@ template<input_stream Ihandler,typename Buf>
 inline constexpr bool irefill(basic_ibuf<Ihandler,Buf>& ib)
 {
 	if(ib.ibuffer.end==nullptr)
+	{
+		details::iobuf_hint_space(ib.ibuffer,ib.ih);
 		ib.ibuffer.init_space();
+	}
 	ib.ibuffer.end=std::copy(ib.ibuffer.curr,ib.ibuffer.end,ib.ibuffer.beg);
 	ib.ibuffer.curr=ib.ibuffer.beg;
 	auto ed{ib.ibuffer.end};
@@ -156,7 +311,7 @@ inline constexpr bool irefill(basic_ibuf<Ihandler,Buf>& ib)
 		fast_terminate();
 #endif
 */
-	ib.ibuffer.end=read(ib.ih,ed,ib.ibuffer.beg+Buf::size);
+	ib.ibuffer.end=read(ib.ih,ed,ib.ibuffer.beg+ib.ibuffer.capacity());
 	return ib.ibuffer.end!=ed;
 }
 
@@ -192,13 +347,23 @@ template<stream Ihandler,typename Buf>
 requires secure_clear_requirement_stream<Ihandler>
 inline constexpr void require_secure_clear(basic_ibuf<Ihandler,Buf>&){}
 
+template<input_stream Ihandler,typename Buf>
+requires requires(Ihandler& ih)
+{
+	{io_buffer_size_hint(ih)}->std::convertible_to<std::size_t>;
+}
+inline constexpr std::size_t io_buffer_size_hint(basic_ibuf<Ihandler,Buf>& ib)
+{
+	return io_buffer_size_hint(ib.native_handle());
+}
+
 template<typename T,typename Iter>
 concept write_read_punned_constraints = (std::contiguous_iterator<Iter>&&sizeof(typename T::char_type)==1) ||
 	(std::random_access_iterator<Iter>&&std::same_as<typename T::char_type,typename std::iterator_traits<Iter>::value_type>);
 
 namespace details
 {
-template<std::size_t buffer_size,bool punning=false,typename T,typename Iter>
+template<bool punning=false,typename T,typename Iter>
 requires std::same_as<std::iter_value_t<Iter>,typename std::remove_cvref_t<T>::char_type>
 inline constexpr Iter ibuf_read_cold(T& ib,Iter begin,Iter end)
 {
@@ -206,8 +371,10 @@ inline constexpr Iter ibuf_read_cold(T& ib,Iter begin,Iter end)
 	std::size_t const buffer_remain(ib.ibuffer.end-ib.ibuffer.curr);
 	if(ib.ibuffer.end==nullptr)
 	{
-		if(buffer_size<=n)
+		iobuf_hint_space(ib.ibuffer,ib.native_handle());
+		if(ib.ibuffer.capacity()<=n)
 		{
+			iobuf_observe_bypass(ib.ibuffer,n);
 			return read(ib.native_handle(),begin,end);
 		}
 		ib.ibuffer.init_space();
@@ -220,8 +387,9 @@ inline constexpr Iter ibuf_read_cold(T& ib,Iter begin,Iter end)
 	}
 	else
 		begin=std::copy_n(ib.ibuffer.curr,buffer_remain,begin);
-	if(begin+buffer_size<end)
+	if(begin+ib.ibuffer.capacity()<end)
 	{
+		iobuf_observe_bypass(ib.ibuffer,static_cast<std::size_t>(end-begin));
 //			if constexpr(std::contiguous_iterator<Iter>)
 			begin=read(ib.native_handle(),begin,end);
 /*			else
@@ -234,7 +402,7 @@ inline constexpr Iter ibuf_read_cold(T& ib,Iter begin,Iter end)
 			return begin;
 		}
 	}
-	ib.ibuffer.end=read(ib.native_handle(),ib.ibuffer.beg,ib.ibuffer.beg+buffer_size);
+	ib.ibuffer.end=read(ib.native_handle(),ib.ibuffer.beg,ib.ibuffer.beg+ib.ibuffer.capacity());
 	ib.ibuffer.curr=ib.ibuffer.beg;
 	n=end-begin;
 	std::size_t const sz(ib.ibuffer.end-ib.ibuffer.beg);
@@ -251,13 +419,13 @@ inline constexpr Iter ibuf_read_cold(T& ib,Iter begin,Iter end)
 	return begin;
 }
 
-template<std::size_t buffer_size,bool punning=false,typename T,typename Iter>
+template<bool punning=false,typename T,typename Iter>
 requires std::same_as<std::iter_value_t<Iter>,typename std::remove_cvref_t<T>::char_type>
 inline constexpr Iter ibuf_read(T& ib,Iter begin,Iter end)
 {
 	std::size_t n(end-begin);
-	if(ib.ibuffer.curr+n<ib.ibuffer.end)[[unlikely]]			//cache miss
-		return ibuf_read_cold<buffer_size,punning>(ib,begin,end);
+	if(ib.ibuffer.end<ib.ibuffer.curr+n)[[unlikely]]			//cache miss
+		return ibuf_read_cold<punning>(ib,begin,end);
 	if constexpr(punning)
 	{
 		std::memcpy(begin,ib.ibuffer.curr,n*sizeof(std::iter_value_t<Iter>));
@@ -279,14 +447,14 @@ inline constexpr Iter read(basic_ibuf<Ihandler,Buf>& ib,Iter begin,Iter end)
 	if constexpr(std::same_as<char_type,typename std::iterator_traits<Iter>::value_type>)
 	{
 		if(std::is_constant_evaluated())
-			return details::ibuf_read<Buf::size>(ib,std::to_address(begin),std::to_address(end));
+			return details::ibuf_read<false>(ib,std::to_address(begin),std::to_address(end));
 		else
-			return details::ibuf_read<Buf::size,true>(ib,std::to_address(begin),std::to_address(end));
+			return details::ibuf_read<true>(ib,std::to_address(begin),std::to_address(end));
 	}
 	else
 	{
 		auto b(reinterpret_cast<char const*>(std::to_address(begin)));
-		return begin+(details::ibuf_read<Buf::size,true>(ib,b,reinterpret_cast<char const*>(std::to_address(end)))-b)/sizeof(*begin);
+		return begin+(details::ibuf_read<true>(ib,b,reinterpret_cast<char const*>(std::to_address(end)))-b)/sizeof(*begin);
 	}
 }
 
@@ -408,6 +576,14 @@ inline constexpr void require_secure_clear(basic_obuf<Ohandler,forcecopy,Buf>&){
 
 namespace details
 {
+template<output_stream Ohandler,bool forcecopy,typename Buf>
+inline constexpr void obuf_init_space(basic_obuf<Ohandler,forcecopy,Buf>& ob)
+{
+	iobuf_hint_space(ob.obuffer,ob.oh);
+	ob.obuffer.init_space();
+	ob.obuffer.end=(ob.obuffer.curr=ob.obuffer.beg)+ob.obuffer.capacity();
+}
+
 template<bool init,bool punning=false,output_stream Ohandler,bool forcecopy,typename Buf,std::contiguous_iterator Iter>
 constexpr void obuf_write_force_copy(basic_obuf<Ohandler,forcecopy,Buf>& ob,Iter cbegin,Iter cend)
 {
@@ -416,17 +592,14 @@ constexpr void obuf_write_force_copy(basic_obuf<Ohandler,forcecopy,Buf>& ob,Iter
 		auto it{write(ob.oh,cbegin,cend)};
 		if(it!=cend)
 		{
-			if(Buf::size<=static_cast<std::size_t>(cend-it))
+			if(ob.obuffer.capacity()<=static_cast<std::size_t>(cend-it))
 #ifdef __cpp_exceptions
 				throw posix_error(EIO);
 #else
 				fast_terminate();
 #endif
 			if constexpr(init)
-			{
-				ob.obuffer.init_space();
-				ob.obuffer.end=(ob.obuffer.curr=ob.obuffer.beg)+Buf::size;
-			}
+				obuf_init_space(ob);
 			else
 				ob.obuffer.curr=ob.obuffer.beg;
 			memcpy(ob.obuffer.beg,std::to_address(it),(cend-it)*sizeof(*cbegin));
@@ -450,10 +623,7 @@ inline constexpr void overflow(basic_obuf<Ohandler,forcecopy,Buf>& ob,typename O
 		details::obuf_write_force_copy<false>(ob,ob.obuffer.beg,ob.obuffer.end);
 	}
 	else	//cold buffer
-	{
-		ob.obuffer.init_space();
-		ob.obuffer.end=(ob.obuffer.curr=ob.obuffer.beg)+Buf::size;
-	}
+		details::obuf_init_space(ob);
 	*ob.obuffer.curr=ch;
 	++ob.obuffer.curr;
 }
@@ -468,8 +638,7 @@ inline constexpr void iobuf_fill_nc_define_code_path(basic_obuf<Ohandler,forceco
 	{
 		if(n==0)[[unlikely]]
 			return;
-		ob.obuffer.init_space();
-		ob.obuffer.end=(ob.obuffer.curr=ob.obuffer.beg)+Buf::size;
+		obuf_init_space(ob);
 	}
 	auto last{ob.obuffer.end};
 	if(ob.obuffer.beg+n<last)
@@ -504,21 +673,50 @@ inline constexpr void fill_nc_define(basic_obuf<Ohandler,forcecopy,Buf>& ob,std:
 namespace details
 {
 
+//write every scatter, resuming after short writes. Batches stay within the 1024 entry limit of writev.
+template<scatter_output_stream output>
+inline void scatter_write_all(output& out,io_scatter_t* first,io_scatter_t* last)
+{
+	constexpr std::size_t max_batch{1024};
+	for(;first!=last;)
+	{
+		io_scatter_t* batch_last{last};
+		if(max_batch<static_cast<std::size_t>(last-first))
+			batch_last=first+max_batch;
+		std::size_t written{scatter_write(out,std::span<io_scatter_t const>(first,batch_last))};
+		for(;first!=batch_last&&first->len<=written;++first)
+			written-=first->len;
+		if(first==batch_last)
+			continue;
+		first->base=static_cast<std::byte const*>(first->base)+written;
+		first->len-=written;
+	}
+}
+
+//pending buffer and a large payload go out in one writev instead of two writes
+template<scatter_output_stream Ohandler,std::integral char_type>
+inline void obuf_scatter_write_cold(Ohandler& oh,char_type const* beg,char_type const* curr,char_type const* first,char_type const* last)
+{
+	io_scatter_t scatters[2]{{beg,static_cast<std::size_t>(curr-beg)*sizeof(char_type)},
+		{first,static_cast<std::size_t>(last-first)*sizeof(char_type)}};
+	scatter_write_all(oh,scatters,scatters+2);
+}
+
 template<bool punning=false,output_stream Ohandler,bool forcecopy,typename Buf,std::contiguous_iterator Iter>
 constexpr void obuf_write_cold(basic_obuf<Ohandler,forcecopy,Buf>& ob,Iter cbegin,Iter cend,std::size_t diff)
 {
-	using T = basic_obuf<Ohandler,forcecopy,Buf>;
 	if(ob.obuffer.end==nullptr)		//cold buffer
 	{
 		if(cend-cbegin==0)
 			return;
-		if(T::buffer_type::size<=diff)
+		iobuf_hint_space(ob.obuffer,ob.oh);
+		if(ob.obuffer.capacity()<=diff)
 		{
+			iobuf_observe_bypass(ob.obuffer,diff);
 			obuf_write_force_copy<true,punning>(ob,cbegin,cend);
 			return;
 		}
-		ob.obuffer.init_space();
-		ob.obuffer.end=(ob.obuffer.curr=ob.obuffer.beg)+T::buffer_type::size;
+		obuf_init_space(ob);
 		if constexpr(punning)
 			memcpy(ob.obuffer.curr,cbegin,diff*sizeof(std::iter_value_t<Iter>));
 		else
@@ -542,6 +740,16 @@ constexpr void obuf_write_cold(basic_obuf<Ohandler,forcecopy,Buf>& ob,Iter cbegi
 	}
 	else
 	{
+		if constexpr(punning&&scatter_output_stream<Ohandler>)
+		{
+			if(ob.obuffer.capacity()<=diff)
+			{
+				obuf_scatter_write_cold(ob.oh,ob.obuffer.beg,ob.obuffer.curr,std::to_address(cbegin),std::to_address(cend));
+				iobuf_observe_bypass(ob.obuffer,diff);
+				ob.obuffer.end=(ob.obuffer.curr=ob.obuffer.beg)+ob.obuffer.capacity();
+				return;
+			}
+		}
 		std::size_t n(ob.obuffer.end-ob.obuffer.curr);
 		if constexpr(punning)
 			memcpy(ob.obuffer.curr,cbegin,n*sizeof(std::iter_value_t<Iter>));
@@ -549,10 +757,11 @@ constexpr void obuf_write_cold(basic_obuf<Ohandler,forcecopy,Buf>& ob,Iter cbegi
 			std::copy_n(cbegin,n,ob.obuffer.curr);	
 		cbegin+=n;
 		write(ob.native_handle(),ob.obuffer.beg,ob.obuffer.end);
-		if(cbegin+(T::buffer_type::size)<cend)
+		if(cbegin+ob.obuffer.capacity()<cend)
 		{
 			write(ob.oh,cbegin,cend);
-			ob.obuffer.curr=ob.obuffer.beg;
+			iobuf_observe_bypass(ob.obuffer,diff);
+			ob.obuffer.end=(ob.obuffer.curr=ob.obuffer.beg)+ob.obuffer.capacity();
 		}
 		else
 		{
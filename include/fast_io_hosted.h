@@ -10,9 +10,22 @@ For hosted implementations the set of standard library headers required by the C
 #include"fast_io_hosted/mmap.h"
 #include"fast_io_hosted/platforms/native.h"
 #include"fast_io_hosted/omap.h"
+#include"fast_io_hosted/direct_io.h"
+#if !defined(__WINNT__) && !defined(_MSC_VER) && !defined(__NEWLIB__)
+#include"fast_io_hosted/huge_page_allocator.h"
+#include"fast_io_hosted/imap.h"
+#endif
 #if !defined(__NEWLIB__)||defined(_GLIBCXX_HAS_GTHREADS)
 #include"fast_io_hosted/iomutex.h"
+#include"fast_io_hosted/buffer_pool.h"
+#include"fast_io_hosted/background_obuf.h"
+#include"fast_io_hosted/ring_log.h"
+#include"fast_io_hosted/parallel_executor.h"
 #include"fast_io_hosted/parallel.h"
+#include"fast_io_hosted/parallel_scan.h"
+#if !defined(__WINNT__) && !defined(_MSC_VER)
+#include"fast_io_hosted/parallel_transmit.h"
+#endif
 #endif
 #include"fast_io_hosted/chrono.h"
 #include"fast_io_hosted/process/native.h"
@@ -1,20 +1,314 @@
 #pragma once
+#include<optional>
+#include<exception>
 
 namespace fast_io
 {
-//This is DAMN bullshit
-struct task
+/*
+task<T> is a lazily started coroutine. Nothing runs until it is awaited or handed to io_async_run. When it finishes,
+it resumes its awaiter by symmetric transfer, so chains of tasks do not grow the stack.
+io_async_run(scheduler,task) starts the task and waits for completions on the scheduler until the task is done.
+The awaiters below keep their completion callback inside the awaiter, so an I/O operation allocates nothing. Their
+callback takes a signed result, the byte count or a negated errno, and a failed operation throws posix_error from
+await_resume inside the coroutine that awaited it.
+task_scope runs many detached task<void> at once. io_async_run(scheduler,scope) returns when all of them are done.
+When a scope is destroyed with tasks still suspended, for example because io_async_run threw, it destroys them. Their
+pending operations must never complete afterwards, so the scheduler must not be waited on again once that happened.
+*/
+
+template<typename T=void>
+class task;
+
+namespace details
+{
+
+class task_promise_base
 {
-struct promise_type
+public:
+	std::coroutine_handle<> continuation{std::noop_coroutine()};
+#ifdef __cpp_exceptions
+	std::exception_ptr ex_ptr;
+#endif
+	struct final_awaiter
+	{
+		constexpr bool await_ready() const noexcept { return false; }
+		template<typename promise_type>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+		{
+			return handle.promise().continuation;
+		}
+		constexpr void await_resume() const noexcept {}
+	};
+	constexpr std::suspend_always initial_suspend() const noexcept { return {}; }
+	constexpr final_awaiter final_suspend() const noexcept { return {}; }
+	void unhandled_exception() noexcept
+	{
+#ifdef __cpp_exceptions
+		ex_ptr = std::current_exception();
+#else
+		std::terminate();
+#endif
+	}
+	void rethrow_if_exception()
+	{
+#ifdef __cpp_exceptions
+		if(ex_ptr)
+			std::rethrow_exception(ex_ptr);
+#endif
+	}
+};
+
+template<typename T>
+class task_promise:public task_promise_base
+{
+public:
+	std::optional<T> value;
+	task<T> get_return_object() noexcept;
+	template<typename U>
+	requires std::constructible_from<T,U>
+	void return_value(U&& v)
+	{
+		value.emplace(std::forward<U>(v));
+	}
+	T result()
+	{
+		rethrow_if_exception();
+		return std::move(*value);
+	}
+};
+
+template<>
+class task_promise<void>:public task_promise_base
 {
-constexpr auto get_return_object() { return task{}; }
-constexpr auto initial_suspend() { return std::suspend_never{}; }
-constexpr auto final_suspend() { return std::suspend_never{}; }
-void unhandled_exception() { std::terminate(); }
-constexpr void return_void() {}
+public:
+	task<void> get_return_object() noexcept;
+	constexpr void return_void() const noexcept {}
+	void result()
+	{
+		rethrow_if_exception();
+	}
 };
+
+}
+
+template<typename T>
+class [[nodiscard]] task
+{
+public:
+	using promise_type = details::task_promise<T>;
+	std::coroutine_handle<promise_type> handle;
+	constexpr task(std::coroutine_handle<promise_type> v) noexcept:handle(v){}
+	task(task const&)=delete;
+	task& operator=(task const&)=delete;
+	constexpr task(task&& other) noexcept:handle(other.handle)
+	{
+		other.handle={};
+	}
+	task& operator=(task&& other) noexcept
+	{
+		if(std::addressof(other)==this)
+			return *this;
+		if(handle)
+			handle.destroy();
+		handle=other.handle;
+		other.handle={};
+		return *this;
+	}
+	~task()
+	{
+		if(handle)
+			handle.destroy();
+	}
+	bool done() const noexcept
+	{
+		return handle.done();
+	}
+	bool await_ready() const noexcept
+	{
+		return handle.done();
+	}
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+	{
+		handle.promise().continuation=awaiting;
+		return handle;
+	}
+	T await_resume()
+	{
+		return handle.promise().result();
+	}
 };
 
+namespace details
+{
+
+template<typename T>
+inline task<T> task_promise<T>::get_return_object() noexcept
+{
+	return {std::coroutine_handle<task_promise<T>>::from_promise(*this)};
+}
+
+inline task<void> task_promise<void>::get_return_object() noexcept
+{
+	return {std::coroutine_handle<task_promise<void>>::from_promise(*this)};
+}
+
+}
+
+template<typename scheduler,typename T>
+inline T io_async_run(scheduler&& sch,task<T> t)
+{
+	t.handle.resume();
+	while(!t.handle.done())
+		io_async_wait(sch);
+	return t.handle.promise().result();
+}
+
+namespace details
+{
+struct task_scope_node
+{
+	task_scope_node* prev{};
+	task_scope_node* next{};
+	std::coroutine_handle<> frame;
+};
+}
+
+class task_scope
+{
+public:
+	std::size_t live{};
+//the frames of the tasks still running
+	details::task_scope_node* detached{};
+#ifdef __cpp_exceptions
+	std::exception_ptr ex_ptr;
+#endif
+	task_scope() noexcept=default;
+	task_scope(task_scope const&)=delete;
+	task_scope& operator=(task_scope const&)=delete;
+	~task_scope()
+	{
+		while(detached)
+			detached->frame.destroy();
+	}
+	constexpr bool empty() const noexcept
+	{
+		return !live;
+	}
+//the task runs right away up to its first suspension
+	inline void spawn(task<void> t);
+	void rethrow_if_exception()
+	{
+#ifdef __cpp_exceptions
+		if(ex_ptr)
+		{
+			auto eptr{std::move(ex_ptr)};
+			ex_ptr=nullptr;
+			std::rethrow_exception(eptr);
+		}
+#endif
+	}
+};
+
+namespace details
+{
+
+struct task_scope_detached
+{
+	struct promise_type:task_scope_node
+	{
+		task_scope& scope;
+		promise_type(task_scope& s,task<void>&) noexcept:scope(s)
+		{
+			frame=std::coroutine_handle<promise_type>::from_promise(*this);
+			next=scope.detached;
+			if(next)
+				next->prev=this;
+			scope.detached=this;
+		}
+		promise_type(promise_type const&)=delete;
+		promise_type& operator=(promise_type const&)=delete;
+		~promise_type()
+		{
+			if(prev)
+				prev->next=next;
+			else
+				scope.detached=next;
+			if(next)
+				next->prev=prev;
+		}
+		constexpr task_scope_detached get_return_object() const noexcept { return {}; }
+		constexpr std::suspend_never initial_suspend() const noexcept { return {}; }
+		constexpr std::suspend_never final_suspend() const noexcept { return {}; }
+		constexpr void return_void() const noexcept {}
+		void unhandled_exception() noexcept { std::terminate(); }
+	};
+};
+
+inline task_scope_detached task_scope_run(task_scope& scope,task<void> t)
+{
+#ifdef __cpp_exceptions
+	try
+	{
+#endif
+		co_await t;
+#ifdef __cpp_exceptions
+	}
+	catch(...)
+	{
+		if(!scope.ex_ptr)
+			scope.ex_ptr=std::current_exception();
+	}
+#endif
+	--scope.live;
+}
+
+}
+
+inline void task_scope::spawn(task<void> t)
+{
+	++live;
+	details::task_scope_run(*this,std::move(t));
+}
+
+//the first exception of the spawned tasks is rethrown once all of them are done
+template<typename scheduler>
+inline void io_async_run(scheduler&& sch,task_scope& scope)
+{
+	while(!scope.empty())
+		io_async_wait(sch);
+	scope.rethrow_if_exception();
+}
+
+namespace details
+{
+
+struct async_coro_resume
+{
+	std::coroutine_handle<> handle;
+	std::ptrdiff_t result{};
+	void operator()(std::ptrdiff_t res) noexcept
+	{
+		result=res;
+		handle.resume();
+	}
+	std::size_t transferred() const
+	{
+		if(result<0)
+			throw_posix_error(static_cast<int>(-result));
+		return static_cast<std::size_t>(result);
+	}
+};
+
+template<typename stm>
+using async_coro_overlapped = typename io_async_overlapped_t<stm>::type::template derived_type<async_coro_resume>;
+
+template<typename stm>
+inline auto async_coro_observer(async_coro_overlapped<stm>& overlapped) noexcept
+{
+	return typename io_async_overlapped_t<stm>::type::observer_type{std::addressof(overlapped)};
+}
+
+}
 
 template<async_input_stream stm,std::input_or_output_iterator Iter1,std::input_or_output_iterator Iter2>
 class async_read
@@ -25,18 +319,13 @@ public:
 	Iter1 beg;
 	Iter2 end;
 	std::ptrdiff_t offset{};
-	std::size_t transferred_size{};
-	typename io_async_overlapped_t<stm>::type overlapped;
+	details::async_coro_overlapped<stm> overlapped{std::in_place};
 	constexpr bool await_ready() const { return false; }
-	constexpr Iter1 await_resume() const { return beg+transferred_size; }
+	constexpr Iter1 await_resume() const { return beg+overlapped.callback.transferred()/sizeof(*beg); }
 	void await_suspend(std::coroutine_handle<> handle)
 	{
-		overlapped=typename io_async_overlapped_t<stm>::type(std::in_place,[handle,this](std::size_t calb)
-		{
-			this->transferred_size=calb/sizeof(*beg);
-			handle.resume();
-		});
-		async_read_callback(sch,sm,beg,end,overlapped,offset*sizeof(*beg));
+		overlapped.callback.handle=handle;
+		async_read_callback(sch,sm,beg,end,details::async_coro_observer<stm>(overlapped),offset*sizeof(*beg));
 	}
 };
 
@@ -44,7 +333,7 @@ template<async_input_stream stm,std::input_or_output_iterator Iter1,
 	std::input_or_output_iterator Iter2> async_read(typename io_async_scheduler_t<stm>::type&,stm&,Iter1,Iter2,std::ptrdiff_t)
 		-> async_read<stm, Iter1, Iter2>;
 template<async_input_stream stm,std::input_or_output_iterator Iter1,
-	std::input_or_output_iterator Iter2> async_read(typename io_async_scheduler_t<stm>::typee&,stm&,Iter1,Iter2)
+	std::input_or_output_iterator Iter2> async_read(typename io_async_scheduler_t<stm>::type&,stm&,Iter1,Iter2)
 		-> async_read<stm, Iter1, Iter2>;
 
 
@@ -59,18 +348,13 @@ public:
 	Iter1 beg;
 	Iter2 end;
 	std::ptrdiff_t offset{-1};
-	std::size_t transferred_size{};
-	typename io_async_overlapped_t<stm>::type overlapped;
+	details::async_coro_overlapped<stm> overlapped{std::in_place};
 	constexpr bool await_ready() const { return false; }
-	constexpr Iter1 await_resume() const { return beg+transferred_size; }
+	constexpr Iter1 await_resume() const { return beg+overlapped.callback.transferred()/sizeof(*beg); }
 	void await_suspend(std::coroutine_handle<> handle)
 	{
-		overlapped=typename io_async_overlapped_t<stm>::type(std::in_place,[handle,this](std::size_t calb)
-		{
-			this->transferred_size=calb/sizeof(*beg);
-			handle.resume();
-		});
-		async_write_callback(sch,sm,beg,end,overlapped,offset*sizeof(*beg));
+		overlapped.callback.handle=handle;
+		async_write_callback(sch,sm,beg,end,details::async_coro_observer<stm>(overlapped),offset*sizeof(*beg));
 	}
 };
 
@@ -84,32 +368,27 @@ template<async_output_stream stm>
 class async_print
 {
 public:
-	typename stm::async_scheduler_type& sch;
+	typename io_async_scheduler_t<stm>::type& sch;
 	stm& sm;
 	std::ptrdiff_t offset{-1};
 	internal_temporary_buffer<typename stm::char_type> buffer;
-	std::size_t transferred_size{};
-	typename io_async_overlapped_t<stm>::type overlapped;
+	details::async_coro_overlapped<stm> overlapped{std::in_place};
 	template<typename ...Args>
-	async_print(typename stm::async_scheduler_type& sh,stm& s,Args&& ...args):sch(sh),sm(s)
+	async_print(typename io_async_scheduler_t<stm>::type& sh,stm& s,Args&& ...args):sch(sh),sm(s)
 	{
 		print(buffer,std::forward<Args>(args)...);
 	}
 	template<typename ...Args>
-	async_print(typename stm::async_scheduler_type& sh,std::ptrdiff_t off,stm& s,Args&& ...args):sch(sh),sm(s),offset(off)
+	async_print(typename io_async_scheduler_t<stm>::type& sh,std::ptrdiff_t off,stm& s,Args&& ...args):sch(sh),sm(s),offset(off)
 	{
 		print(buffer,std::forward<Args>(args)...);
 	}
 	constexpr bool await_ready() const { return false; }
-	constexpr std::size_t await_resume() const { return transferred_size; }
+	constexpr std::size_t await_resume() const { return overlapped.callback.transferred()/sizeof(typename stm::char_type); }
 	void await_suspend(std::coroutine_handle<> handle)
 	{
-		overlapped=typename io_async_overlapped_t<stm>::type(std::in_place,[handle,this](std::size_t calb)
-		{
-			this->transferred_size=calb/sizeof(typename stm::char_type);
-			handle.resume();
-		});
-		async_write_callback(sch,sm,buffer.beg_ptr,buffer.end_ptr,overlapped,offset*sizeof(typename stm::char_type));
+		overlapped.callback.handle=handle;
+		async_write_callback(sch,sm,buffer.beg_ptr,buffer.end_ptr,details::async_coro_observer<stm>(overlapped),offset*sizeof(typename stm::char_type));
 	}
 };
 
@@ -120,32 +399,27 @@ template<async_output_stream stm>
 class async_println
 {
 public:
-	typename stm::async_scheduler_type& sch;
+	typename io_async_scheduler_t<stm>::type& sch;
 	stm& sm;
 	std::ptrdiff_t offset{-1};
 	internal_temporary_buffer<typename stm::char_type> buffer;
-	std::size_t transferred_size{};
-	typename io_async_overlapped_t<stm>::type overlapped;
+	details::async_coro_overlapped<stm> overlapped{std::in_place};
 	template<typename ...Args>
-	async_println(typename stm::async_scheduler_type& sh,stm& s,Args&& ...args):sch(sh),sm(s)
+	async_println(typename io_async_scheduler_t<stm>::type& sh,stm& s,Args&& ...args):sch(sh),sm(s)
 	{
 		println(buffer,std::forward<Args>(args)...);
 	}
 	template<typename ...Args>
-	async_println(typename stm::async_scheduler_type& sh,std::ptrdiff_t off,stm& s,Args&& ...args):sch(sh),sm(s),offset(off)
+	async_println(typename io_async_scheduler_t<stm>::type& sh,std::ptrdiff_t off,stm& s,Args&& ...args):sch(sh),sm(s),offset(off)
 	{
 		println(buffer,std::forward<Args>(args)...);
 	}
 	constexpr bool await_ready() const { return false; }
-	constexpr std::size_t await_resume() const { return transferred_size; }
+	constexpr std::size_t await_resume() const { return overlapped.callback.transferred()/sizeof(typename stm::char_type); }
 	void await_suspend(std::coroutine_handle<> handle)
 	{
-		overlapped=typename io_async_overlapped_t<stm>::type(std::in_place,[handle,this](std::size_t calb)
-		{
-			this->transferred_size=calb/sizeof(typename stm::char_type);
-			handle.resume();
-		});
-		async_write_callback(sch,sm,buffer.beg_ptr,buffer.end_ptr,overlapped,offset*sizeof(typename stm::char_type));
+		overlapped.callback.handle=handle;
+		async_write_callback(sch,sm,buffer.beg_ptr,buffer.end_ptr,details::async_coro_observer<stm>(overlapped),offset*sizeof(typename stm::char_type));
 	}
 };
 
@@ -156,22 +430,17 @@ template<typename stm>
 class async_scatter_write
 {
 public:
-	typename stm::async_scheduler_type& sch;
+	typename io_async_scheduler_t<stm>::type& sch;
 	stm& sm;
 	std::span<io_scatter_t const> span;
 	std::ptrdiff_t offset{};
-	std::size_t transferred_size{};
-	typename io_async_overlapped_t<stm>::type overlapped;
+	details::async_coro_overlapped<stm> overlapped{std::in_place};
 	constexpr bool await_ready() const { return false; }
-	constexpr std::size_t await_resume() const { return transferred_size; }
+	constexpr std::size_t await_resume() const { return overlapped.callback.transferred(); }
 	void await_suspend(std::coroutine_handle<> handle)
 	{
-		overlapped=typename io_async_overlapped_t<stm>::type(std::in_place,[handle,this](std::size_t calb)
-		{
-			this->transferred_size=calb;
-			handle.resume();
-		});
-		async_scatter_write_callback(sch,sm,span,overlapped,offset);
+		overlapped.callback.handle=handle;
+		async_scatter_write_callback(sch,sm,span,details::async_coro_observer<stm>(overlapped),offset);
 	}
 };
 
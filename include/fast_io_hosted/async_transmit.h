@@ -16,20 +16,36 @@ public:
 	using char_type = typename std::remove_cvref_t<input>::char_type;
 	static inline constexpr std::size_t buffer_size{details::cal_buffer_size<char_type>()};
 	std::uintmax_t transferred{};
+//errno of the operation that failed. await_resume throws it.
+	int error{};
 	std::unique_ptr<char_type[]> uptr{new char_type[buffer_size]};
 	typename io_async_overlapped_t<output>::type output_overlapped;
 	typename io_async_overlapped_t<input>::type input_overlapped;
 	
 	constexpr bool await_ready() const { return false; }
-	constexpr std::uintmax_t await_resume() const { return transferred; }
+	std::uintmax_t await_resume() const
+	{
+		if(error)
+			throw_posix_error(error);
+		return transferred;
+	}
 	void await_suspend(std::coroutine_handle<> handle)
 	{
-		output_overlapped=typename io_async_overlapped_t<output>::type(std::in_place,[this](std::size_t calb)
+		output_overlapped=typename io_async_overlapped_t<output>::type(std::in_place,[handle,this](std::ptrdiff_t res)
 		{
+			if(res<0)
+			{
+				this->error=static_cast<int>(-res);
+				handle.resume();
+				return;
+			}
 			async_read_callback(this->in_sch,this->in,uptr.get(),uptr.get()+buffer_size,this->input_overlapped);
 		});
-		input_overlapped=typename io_async_overlapped_t<input>::type(std::in_place,[handle,this](std::size_t calb)
+		input_overlapped=typename io_async_overlapped_t<input>::type(std::in_place,[handle,this](std::ptrdiff_t res)
 		{
+			if(res<0)
+				this->error=static_cast<int>(-res);
+			std::size_t const calb(res<0?0:res);
 			this->transferred+=calb/sizeof(typename input::char_type);
 			if(calb==0)
 				handle.resume();
@@ -50,15 +66,28 @@ public:
 	using char_type = typename std::remove_cvref_t<input>::char_type;
 	static inline constexpr std::size_t buffer_size{details::cal_buffer_size<char_type>()};
 	std::uintmax_t transferred{};
+//errno of the operation that failed. await_resume throws it.
+	int error{};
 	std::unique_ptr<char_type[]> uptr{new char_type[buffer_size]};
 	typename io_async_overlapped_t<output>::type output_overlapped;
 	
 	constexpr bool await_ready() const { return false; }
-	constexpr std::uintmax_t await_resume() const { return transferred; }
+	std::uintmax_t await_resume() const
+	{
+		if(error)
+			throw_posix_error(error);
+		return transferred;
+	}
 	void await_suspend(std::coroutine_handle<> handle)
 	{
-		output_overlapped=typename io_async_overlapped_t<output>::type(std::in_place,[handle,this](std::size_t)
+		output_overlapped=typename io_async_overlapped_t<output>::type(std::in_place,[handle,this](std::ptrdiff_t res)
 		{
+			if(res<0)
+			{
+				this->error=static_cast<int>(-res);
+				handle.resume();
+				return;
+			}
 			auto it{read(this->in,uptr.get(),uptr.get()+buffer_size)};
 			if(it==uptr.get())
 				handle.resume();
@@ -89,14 +118,27 @@ public:
 	using char_type = typename std::remove_cvref_t<input>::char_type;
 	static inline constexpr std::size_t buffer_size{details::cal_buffer_size<char_type>()};
 	std::uintmax_t transferred{};
+//errno of the operation that failed. await_resume throws it.
+	int error{};
 	typename io_async_overlapped_t<output>::type output_overlapped;
 	
 	constexpr bool await_ready() const { return false; }
-	constexpr std::uintmax_t await_resume() const { return transferred; }
+	std::uintmax_t await_resume() const
+	{
+		if(error)
+			throw_posix_error(error);
+		return transferred;
+	}
 	void await_suspend(std::coroutine_handle<> handle)
 	{
-		output_overlapped=typename io_async_overlapped_t<output>::type(std::in_place,[handle,this](std::size_t)
+		output_overlapped=typename io_async_overlapped_t<output>::type(std::in_place,[handle,this](std::ptrdiff_t res)
 		{
+			if(res<0)
+			{
+				this->error=static_cast<int>(-res);
+				handle.resume();
+				return;
+			}
 			if(underflow(in))
 			{
 				auto b{ibuffer_curr(in)};
@@ -136,15 +178,25 @@ public:
 	using char_type = typename std::remove_cvref_t<input>::char_type;
 	static inline constexpr std::size_t buffer_size{details::cal_buffer_size<char_type>()};
 	std::uintmax_t transferred{};
+//errno of the operation that failed. await_resume throws it.
+	int error{};
 	std::unique_ptr<char_type[]> uptr{new char_type[buffer_size]};
 	typename io_async_overlapped_t<input>::type input_overlapped;
 
 	constexpr bool await_ready() const { return false; }
-	constexpr std::uintmax_t await_resume() const { return transferred; }
+	std::uintmax_t await_resume() const
+	{
+		if(error)
+			throw_posix_error(error);
+		return transferred;
+	}
 	void await_suspend(std::coroutine_handle<> handle)
 	{
-		input_overlapped=typename io_async_overlapped_t<input>::type(std::in_place,[handle,this](std::size_t calb)
+		input_overlapped=typename io_async_overlapped_t<input>::type(std::in_place,[handle,this](std::ptrdiff_t res)
 		{
+			if(res<0)
+				this->error=static_cast<int>(-res);
+			std::size_t const calb(res<0?0:res);
 			this->transferred+=calb/sizeof(typename input::char_type);
 			if(calb==0)
 				handle.resume();
@@ -0,0 +1,278 @@
+#pragma once
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <exception>
+
+namespace fast_io
+{
+
+/*
+basic_background_obuf is an N-buffered output stream. The producer fills one buffer with the same inline fast path
+as basic_obuf. A full buffer is handed to a dedicated flusher thread that calls write on the native handle, while the
+producer continues with the next free buffer. If all buffers are in flight, the producer waits (bounded backpressure).
+flush() returns only after every byte written before it has been passed to write(oh,...), just like basic_obuf.
+Errors thrown by the flusher are rethrown to the producer on the next overflow or flush.
+*/
+
+template<output_stream Ohandler,std::size_t buffers=2,
+	std::size_t buffer_size = details::cal_buffer_size<typename Ohandler::char_type,true>(),
+	typename Allocator = io_aligned_allocator<typename Ohandler::char_type>>
+requires (2<=buffers&&buffer_size!=0)
+class basic_background_obuf
+{
+public:
+	using native_handle_type = Ohandler;
+	using char_type = typename Ohandler::char_type;
+	using allocator_type = Allocator;
+	static inline constexpr std::size_t size = buffer_size;
+	static inline constexpr std::size_t buffers_size = buffers;
+	Ohandler oh;
+	char_type *beg{},*curr{},*end{};
+private:
+	struct pending_buffer
+	{
+		char_type *beg,*end;
+	};
+	Allocator alloc;
+	std::array<char_type*,buffers> storage{};
+	std::array<pending_buffer,buffers> pending{};
+	std::size_t pending_front{},pending_size{};
+	std::array<char_type*,buffers> free_list{};
+	std::size_t free_size{};
+	bool busy{};
+	bool stopping{};
+#ifdef __cpp_exceptions
+	std::exception_ptr error;
+#endif
+	std::mutex mtx;
+	std::condition_variable producer_cv,consumer_cv;
+	std::thread flusher;
+
+	void rethrow_error_locked()
+	{
+#ifdef __cpp_exceptions
+		if(error)[[unlikely]]
+		{
+			auto eptr{std::move(error)};
+			error=nullptr;
+			std::rethrow_exception(eptr);
+		}
+#endif
+	}
+	void flusher_loop() noexcept
+	{
+		std::unique_lock lk{mtx};
+		for(;;)
+		{
+			consumer_cv.wait(lk,[this]{return pending_size!=0||stopping;});
+			if(pending_size==0)
+				return;
+			auto [b,e]{pending[pending_front]};
+			if(++pending_front==buffers)
+				pending_front=0;
+			--pending_size;
+			busy=true;
+			lk.unlock();
+#ifdef __cpp_exceptions
+			try
+			{
+#endif
+				write(oh,b,e);
+#ifdef __cpp_exceptions
+			}
+			catch(...)
+			{
+				lk.lock();
+				if(!error)
+					error=std::current_exception();
+				lk.unlock();
+			}
+#endif
+			lk.lock();
+			busy=false;
+			free_list[free_size]=b;
+			++free_size;
+			producer_cv.notify_all();
+		}
+	}
+	void submit_locked(std::unique_lock<std::mutex>& lk)
+	{
+		if(curr==beg)
+			return;
+		std::size_t pos{pending_front+pending_size};
+		if(buffers<=pos)
+			pos-=buffers;
+		pending[pos]={beg,curr};
+		++pending_size;
+		consumer_cv.notify_one();
+		producer_cv.wait(lk,[this]{return free_size!=0;});
+		--free_size;
+		end=(curr=beg=free_list[free_size])+buffer_size;
+	}
+	void close_impl() noexcept
+	{
+		if(!flusher.joinable())
+			return;
+		{
+			std::unique_lock lk{mtx};
+			submit_locked(lk);
+			stopping=true;
+			consumer_cv.notify_one();
+		}
+		flusher.join();
+		for(auto e : storage)
+			std::allocator_traits<allocator_type>::deallocate(alloc,e,buffer_size);
+	}
+public:
+	template<typename... Args>
+	requires std::constructible_from<Ohandler,Args...>
+	basic_background_obuf(Args&&... args):oh(std::forward<Args>(args)...)
+	{
+		std::size_t i{};
+#ifdef __cpp_exceptions
+		try
+		{
+#endif
+			for(;i!=buffers;++i)
+				storage[i]=std::allocator_traits<allocator_type>::allocate(alloc,buffer_size);
+			end=(curr=beg=storage.front())+buffer_size;
+			for(std::size_t j{1};j!=buffers;++j)
+				free_list[free_size++]=storage[j];
+//the destructor does not run when the constructor throws, so a thread that fails to start must not leak the buffers
+			flusher=std::thread([this]{flusher_loop();});
+#ifdef __cpp_exceptions
+		}
+		catch(...)
+		{
+			for(std::size_t j{};j!=i;++j)
+				std::allocator_traits<allocator_type>::deallocate(alloc,storage[j],buffer_size);
+			throw;
+		}
+#endif
+	}
+	basic_background_obuf(basic_background_obuf const&)=delete;
+	basic_background_obuf& operator=(basic_background_obuf const&)=delete;
+	~basic_background_obuf()
+	{
+		close_impl();
+	}
+	inline constexpr auto& native_handle() noexcept
+	{
+		return oh;
+	}
+//hand the current buffer to the flusher and continue with a free one. Waits if every buffer is in flight.
+	void swap_buffer()
+	{
+		std::unique_lock lk{mtx};
+		rethrow_error_locked();
+		submit_locked(lk);
+		rethrow_error_locked();
+	}
+//wait until all submitted buffers have been written to oh
+	void drain()
+	{
+		std::unique_lock lk{mtx};
+		submit_locked(lk);
+		producer_cv.wait(lk,[this]{return pending_size==0&&!busy;});
+		rethrow_error_locked();
+	}
+};
+
+template<output_stream Ohandler,std::size_t buffers,std::size_t buffer_size,typename Allocator>
+[[nodiscard]] inline constexpr auto obuffer_begin(basic_background_obuf<Ohandler,buffers,buffer_size,Allocator>& ob)
+{
+	return ob.beg;
+}
+
+template<output_stream Ohandler,std::size_t buffers,std::size_t buffer_size,typename Allocator>
+[[nodiscard]] inline constexpr auto obuffer_curr(basic_background_obuf<Ohandler,buffers,buffer_size,Allocator>& ob)
+{
+	return ob.curr;
+}
+
+template<output_stream Ohandler,std::size_t buffers,std::size_t buffer_size,typename Allocator>
+[[nodiscard]] inline constexpr auto obuffer_end(basic_background_obuf<Ohandler,buffers,buffer_size,Allocator>& ob)
+{
+	return ob.end;
+}
+
+template<output_stream Ohandler,std::size_t buffers,std::size_t buffer_size,typename Allocator>
+inline constexpr void obuffer_set_curr(basic_background_obuf<Ohandler,buffers,buffer_size,Allocator>& ob,typename Ohandler::char_type* ptr)
+{
+	ob.curr=ptr;
+}
+
+template<output_stream Ohandler,std::size_t buffers,std::size_t buffer_size,typename Allocator>
+inline void overflow(basic_background_obuf<Ohandler,buffers,buffer_size,Allocator>& ob,typename Ohandler::char_type ch)
+{
+	ob.swap_buffer();
+	*ob.curr=ch;
+	++ob.curr;
+}
+
+namespace details
+{
+template<output_stream Ohandler,std::size_t buffers,std::size_t buffer_size,typename Allocator>
+inline void background_obuf_write_cold(basic_background_obuf<Ohandler,buffers,buffer_size,Allocator>& ob,
+	typename Ohandler::char_type const* first,typename Ohandler::char_type const* last)
+{
+	using char_type = typename Ohandler::char_type;
+	for(std::size_t n(last-first);;)
+	{
+		std::size_t remain(ob.end-ob.curr);
+		if(n<remain)
+		{
+			memcpy(ob.curr,first,n*sizeof(char_type));
+			ob.curr+=n;
+			return;
+		}
+		memcpy(ob.curr,first,remain*sizeof(char_type));
+		ob.curr+=remain;
+		first+=remain;
+		n-=remain;
+		ob.swap_buffer();
+	}
+}
+}
+
+template<output_stream Ohandler,std::size_t buffers,std::size_t buffer_size,typename Allocator,std::contiguous_iterator Iter>
+requires (write_read_punned_constraints<basic_background_obuf<Ohandler,buffers,buffer_size,Allocator>,Iter>)
+inline void write(basic_background_obuf<Ohandler,buffers,buffer_size,Allocator>& ob,Iter cbegini,Iter cendi)
+{
+	using char_type = typename Ohandler::char_type;
+	char_type const* first;
+	char_type const* last;
+	if constexpr(std::same_as<char_type,std::iter_value_t<Iter>>)
+	{
+		first=std::to_address(cbegini);
+		last=std::to_address(cendi);
+	}
+	else
+	{
+		first=reinterpret_cast<char_type const*>(std::to_address(cbegini));
+		last=reinterpret_cast<char_type const*>(std::to_address(cendi));
+	}
+	std::size_t const diff(last-first);
+	if(ob.curr+diff<ob.end)[[likely]]
+	{
+		memcpy(ob.curr,first,diff*sizeof(char_type));
+		ob.curr+=diff;
+		return;
+	}
+	details::background_obuf_write_cold(ob,first,last);
+}
+
+template<output_stream Ohandler,std::size_t buffers,std::size_t buffer_size,typename Allocator>
+inline void flush(basic_background_obuf<Ohandler,buffers,buffer_size,Allocator>& ob)
+{
+	ob.drain();
+}
+
+template<redirect_stream Ohandler,std::size_t buffers,std::size_t buffer_size,typename Allocator>
+inline constexpr decltype(auto) redirect_handle(basic_background_obuf<Ohandler,buffers,buffer_size,Allocator>& ob)
+{
+	return redirect_handle(ob.native_handle());
+}
+
+}
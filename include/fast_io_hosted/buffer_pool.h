@@ -0,0 +1,312 @@
+#pragma once
+#include <mutex>
+
+namespace fast_io
+{
+
+struct io_buffer_pool_statistics
+{
+	std::size_t hits{};
+	std::size_t overflow_hits{};
+	std::size_t misses{};
+};
+
+/*
+io_buffer_pool recycles io buffers instead of returning them to operator new.
+Every thread keeps a small cache of free blocks grouped by exact byte size. When a thread cache is full, blocks go to
+a global overflow list protected by a mutex. When the global list is full too, blocks are freed.
+Freed blocks are reused as-is. basic_buf_handler<CharT,true> calls secure_clear before deallocate, so buffers of
+secure streams are already wiped when they enter the pool.
+Statistics are counted per thread with plain relaxed stores, so allocate never does a locked read-modify-write for
+them. statistics() sums the counters of the live threads with those retired by threads that have exited.
+*/
+
+template<std::size_t alignment=4096>
+class io_buffer_pool
+{
+	struct node
+	{
+		node* next;
+	};
+	struct bucket
+	{
+		std::size_t bytes{};
+		std::size_t count{};
+		node* head{};
+	};
+	static inline constexpr std::size_t buckets_size{8};
+	static inline constexpr std::size_t thread_bucket_capacity{16};
+	static inline constexpr std::size_t global_bucket_capacity{256};
+
+	static inline void* allocate_new(std::size_t bytes)
+	{
+#if __cpp_sized_deallocation >=	201309L && __cpp_aligned_new >= 201606L
+		return operator new(bytes,std::align_val_t{alignment});
+#else
+		return operator new(bytes);
+#endif
+	}
+	static inline void deallocate_new(void* p,[[maybe_unused]] std::size_t bytes) noexcept
+	{
+#if __cpp_sized_deallocation >=	201309L && __cpp_aligned_new >= 201606L
+		operator delete(p,bytes,std::align_val_t{alignment});
+#else
+		operator delete(p);
+#endif
+	}
+	static inline bucket* find_bucket(std::array<bucket,buckets_size>& buckets,std::size_t bytes) noexcept
+	{
+		bucket* empty{};
+		for(auto& e : buckets)
+		{
+			if(e.bytes==bytes)
+				return std::addressof(e);
+			if(empty==nullptr&&e.count==0)
+				empty=std::addressof(e);
+		}
+		if(empty)
+			empty->bytes=bytes;
+		return empty;
+	}
+	static inline void* pop(bucket& b) noexcept
+	{
+		node* n{b.head};
+		b.head=n->next;
+		--b.count;
+		return n;
+	}
+	static inline void push(bucket& b,void* p) noexcept
+	{
+		node* n{static_cast<node*>(p)};
+		n->next=b.head;
+		b.head=n;
+		++b.count;
+	}
+
+	struct counter
+	{
+		std::atomic<std::size_t> value{};
+//only the owning thread writes, other threads only read
+		void increment() noexcept
+		{
+			value.store(value.load(std::memory_order_relaxed)+1,std::memory_order_relaxed);
+		}
+		std::size_t load() const noexcept
+		{
+			return value.load(std::memory_order_relaxed);
+		}
+	};
+	struct thread_cache;
+
+	struct global_cache
+	{
+		std::mutex mtx;
+		std::array<bucket,buckets_size> buckets{};
+		thread_cache* threads{};
+		io_buffer_pool_statistics retired{};
+		void put(void* p,std::size_t bytes) noexcept
+		{
+			{
+				std::lock_guard lg{mtx};
+				auto b{find_bucket(buckets,bytes)};
+				if(b&&b->count<global_bucket_capacity)
+				{
+					push(*b,p);
+					return;
+				}
+			}
+			deallocate_new(p,bytes);
+		}
+		void* get(std::size_t bytes) noexcept
+		{
+			std::lock_guard lg{mtx};
+			for(auto& e : buckets)
+				if(e.bytes==bytes&&e.count)
+					return pop(e);
+			return nullptr;
+		}
+//allocations of a thread whose cache is already destroyed are counted here
+		void* get_retired(std::size_t bytes)
+		{
+			{
+				std::lock_guard lg{mtx};
+				for(auto& e : buckets)
+					if(e.bytes==bytes&&e.count)
+					{
+						++retired.overflow_hits;
+						return pop(e);
+					}
+				++retired.misses;
+			}
+			return allocate_new(bytes);
+		}
+	};
+//global cache is intentionally never destroyed so streams with static storage duration can still return buffers.
+	static inline global_cache& global() noexcept
+	{
+		alignas(global_cache) static std::byte storage[sizeof(global_cache)];
+		static global_cache* gc{new (storage) global_cache};
+		return *gc;
+	}
+
+	struct thread_cache
+	{
+		std::array<bucket,buckets_size> buckets{};
+		counter hits;
+		counter overflow_hits;
+		counter misses;
+		thread_cache* prev{};
+		thread_cache* next{};
+		thread_cache() noexcept
+		{
+			auto& gc{global()};
+			std::lock_guard lg{gc.mtx};
+			next=gc.threads;
+			if(next)
+				next->prev=this;
+			gc.threads=this;
+		}
+		thread_cache(thread_cache const&)=delete;
+		thread_cache& operator=(thread_cache const&)=delete;
+		~thread_cache()
+		{
+			thread_cache_destroyed=true;
+			{
+				auto& gc{global()};
+				std::lock_guard lg{gc.mtx};
+				if(prev)
+					prev->next=next;
+				else
+					gc.threads=next;
+				if(next)
+					next->prev=prev;
+				gc.retired.hits+=hits.load();
+				gc.retired.overflow_hits+=overflow_hits.load();
+				gc.retired.misses+=misses.load();
+			}
+			for(auto& e : buckets)
+				for(;e.count;)
+					global().put(pop(e),e.bytes);
+		}
+	};
+	static inline thread_local thread_cache local;
+	static inline thread_local bool thread_cache_destroyed{};
+public:
+	static inline void* allocate(std::size_t bytes)
+	{
+		if(bytes<sizeof(node))
+			bytes=sizeof(node);
+		if(thread_cache_destroyed)[[unlikely]]
+			return global().get_retired(bytes);
+		auto& tc{local};
+		for(auto& e : tc.buckets)
+			if(e.bytes==bytes&&e.count)
+			{
+				tc.hits.increment();
+				return pop(e);
+			}
+		if(auto p{global().get(bytes)};p)
+		{
+			tc.overflow_hits.increment();
+			return p;
+		}
+		tc.misses.increment();
+		return allocate_new(bytes);
+	}
+	static inline void deallocate(void* p,std::size_t bytes) noexcept
+	{
+		if(p==nullptr)
+			return;
+		if(bytes<sizeof(node))
+			bytes=sizeof(node);
+		if(!thread_cache_destroyed)[[likely]]
+		{
+			auto b{find_bucket(local.buckets,bytes)};
+			if(b&&b->count<thread_bucket_capacity)
+			{
+				push(*b,p);
+				return;
+			}
+		}
+		global().put(p,bytes);
+	}
+	static inline io_buffer_pool_statistics statistics() noexcept
+	{
+		auto& gc{global()};
+		std::lock_guard lg{gc.mtx};
+		io_buffer_pool_statistics st{gc.retired};
+		for(auto p{gc.threads};p;p=p->next)
+		{
+			st.hits+=p->hits.load();
+			st.overflow_hits+=p->overflow_hits.load();
+			st.misses+=p->misses.load();
+		}
+		return st;
+	}
+//return all cached blocks of the calling thread to the global overflow list
+	static inline void trim() noexcept
+	{
+		if(thread_cache_destroyed)
+			return;
+		for(auto& e : local.buckets)
+			for(;e.count;)
+				global().put(pop(e),e.bytes);
+	}
+};
+
+template<typename T,std::size_t alignment=4096>
+struct io_pool_allocator
+{
+	using value_type = T;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using pool_type = io_buffer_pool<alignment>;
+	template<typename U>
+	struct rebind
+	{
+		using other = io_pool_allocator<U,alignment>;
+	};
+	constexpr io_pool_allocator() noexcept = default;
+	template<typename U>
+	constexpr io_pool_allocator(io_pool_allocator<U,alignment> const&) noexcept{}
+	[[nodiscard]] inline
+	#if __cpp_lib_is_constant_evaluated >= 201811L && __cpp_constexpr_dynamic_alloc >= 201907L
+		constexpr
+	#endif
+	T* allocate(std::size_t n)
+	{
+	#if __cpp_lib_is_constant_evaluated >= 201811L && __cpp_constexpr_dynamic_alloc >= 201907L
+		if(std::is_constant_evaluated())
+			return new T[n];
+		else
+	#endif
+			return static_cast<T*>(pool_type::allocate(n*sizeof(T)));
+	}
+	inline
+	#if __cpp_lib_is_constant_evaluated >= 201811L && __cpp_constexpr_dynamic_alloc >= 201907L
+		constexpr
+	#endif
+	void deallocate(T* p,std::size_t n) noexcept
+	{
+	#if __cpp_lib_is_constant_evaluated >= 201811L && __cpp_constexpr_dynamic_alloc >= 201907L
+		if(std::is_constant_evaluated())
+			delete[] p;
+		else
+	#endif
+			pool_type::deallocate(p,n*sizeof(T));
+	}
+	static inline io_buffer_pool_statistics statistics() noexcept
+	{
+		return pool_type::statistics();
+	}
+	template<typename U>
+	inline constexpr bool operator==(io_pool_allocator<U,alignment> const&) const noexcept
+	{
+		return true;
+	}
+};
+
+template<std::integral CharT,bool need_secure_clear=false,std::size_t buffer_size = details::cal_buffer_size<CharT,true>()>
+using basic_pool_buf_handler = basic_buf_handler<CharT,need_secure_clear,buffer_size,io_pool_allocator<CharT>>;
+
+}
@@ -0,0 +1,346 @@
+#pragma once
+
+namespace fast_io
+{
+
+/*
+Streams for files opened with open_mode::direct (O_DIRECT). Buffers are aligned and their capacity is a multiple of
+the block size reported by io_direct_alignment, and never smaller than 4096. Every read and write issued to the
+native handle starts at a block boundary and covers whole blocks, so user data never goes to the device unaligned.
+*/
+
+namespace details
+{
+template<std::integral char_type,typename T>
+inline std::size_t direct_io_block_size(T& handle)
+{
+	std::size_t alignment{};
+	if constexpr(requires()
+	{
+		{io_direct_alignment(handle)}->std::convertible_to<std::size_t>;
+	})
+		alignment=io_direct_alignment(handle);
+	if(alignment<4096)
+		alignment=4096;
+	if(alignment%sizeof(char_type))
+		throw_posix_error(EINVAL);
+	return alignment/sizeof(char_type);
+}
+
+inline constexpr std::size_t direct_io_round_up(std::size_t n,std::size_t block_size) noexcept
+{
+	return (n+block_size-1)/block_size*block_size;
+}
+
+template<typename T,typename char_type>
+inline void direct_io_write_all(T& handle,char_type const* first,char_type const* last)
+{
+	while(first!=last)
+	{
+		auto it{write(handle,first,last)};
+		if(it==first)
+			throw_posix_error(EIO);
+		first=it;
+	}
+}
+}
+
+template<output_stream Ohandler,std::size_t buffer_size = details::cal_buffer_size<typename Ohandler::char_type,true>(),
+	typename Allocator = io_aligned_allocator<typename Ohandler::char_type>>
+requires (random_access_stream<Ohandler>&&buffer_size!=0)
+class basic_direct_obuf
+{
+public:
+	using native_handle_type = Ohandler;
+	using char_type = typename Ohandler::char_type;
+	using allocator_type = Allocator;
+	Ohandler oh;
+	char_type *beg{},*curr{},*end{};
+private:
+	Allocator alloc;
+	std::size_t block_size{};
+	std::uintmax_t start_position{};
+	std::uintmax_t committed{};
+	void close_impl() noexcept
+	{
+		if(beg==nullptr)
+			return;
+#ifdef __cpp_exceptions
+		try
+		{
+#endif
+			sync_impl<false>();
+#ifdef __cpp_exceptions
+		}
+		catch(...){}
+#endif
+		std::allocator_traits<allocator_type>::deallocate(alloc,beg,end-beg);
+		beg=curr=end=nullptr;
+	}
+public:
+	template<typename... Args>
+	requires std::constructible_from<Ohandler,Args...>
+	basic_direct_obuf(Args&&... args):oh(std::forward<Args>(args)...)
+	{
+		block_size=details::direct_io_block_size<char_type>(oh);
+		start_position=static_cast<std::uintmax_t>(seek(oh,0,seekdir::cur));
+		if(start_position%(block_size*sizeof(char_type)))
+			throw_posix_error(EINVAL);
+		std::size_t const capacity{details::direct_io_round_up(buffer_size,block_size)};
+		end=(curr=beg=std::allocator_traits<allocator_type>::allocate(alloc,capacity))+capacity;
+	}
+	basic_direct_obuf(basic_direct_obuf const&)=delete;
+	basic_direct_obuf& operator=(basic_direct_obuf const&)=delete;
+	~basic_direct_obuf()
+	{
+		close_impl();
+	}
+	inline constexpr auto& native_handle() noexcept
+	{
+		return oh;
+	}
+	inline constexpr std::size_t direct_block_size() const noexcept
+	{
+		return block_size;
+	}
+//write every complete block and keep the partial tail in the buffer
+	void commit_blocks()
+	{
+		std::size_t const n(curr-beg);
+		std::size_t const full{n/block_size*block_size};
+		if(full==0)
+			return;
+		details::direct_io_write_all(oh,beg,beg+full);
+		committed+=full;
+		std::size_t const tail{n-full};
+		memmove(beg,beg+full,tail*sizeof(char_type));
+		curr=beg+tail;
+	}
+/*
+write everything including the partial tail. The tail is padded with zeros to a whole block, the file is truncated
+back to its logical size and, when keep_tail is true, the tail stays in the buffer and the position is moved back so
+the block is rewritten on the next write.
+*/
+	template<bool keep_tail=true>
+	void sync_impl()
+	{
+		std::size_t const n(curr-beg);
+		std::size_t const full{n/block_size*block_size};
+		std::size_t const tail{n-full};
+		if(tail==0)
+		{
+			details::direct_io_write_all(oh,beg,curr);
+			committed+=full;
+			curr=beg;
+			return;
+		}
+		std::size_t const padded{full+block_size};
+		std::fill(curr,beg+padded,char_type{});
+		details::direct_io_write_all(oh,beg,beg+padded);
+		truncate(oh,start_position+(committed+n)*sizeof(char_type));
+		committed+=full;
+		if constexpr(keep_tail)
+		{
+			seek(oh,-static_cast<std::intmax_t>(block_size*sizeof(char_type)),seekdir::cur);
+			memmove(beg,beg+full,tail*sizeof(char_type));
+			curr=beg+tail;
+		}
+		else
+			curr=beg;
+	}
+};
+
+template<output_stream Ohandler,std::size_t buffer_size,typename Allocator>
+[[nodiscard]] inline constexpr auto obuffer_begin(basic_direct_obuf<Ohandler,buffer_size,Allocator>& ob)
+{
+	return ob.beg;
+}
+
+template<output_stream Ohandler,std::size_t buffer_size,typename Allocator>
+[[nodiscard]] inline constexpr auto obuffer_curr(basic_direct_obuf<Ohandler,buffer_size,Allocator>& ob)
+{
+	return ob.curr;
+}
+
+template<output_stream Ohandler,std::size_t buffer_size,typename Allocator>
+[[nodiscard]] inline constexpr auto obuffer_end(basic_direct_obuf<Ohandler,buffer_size,Allocator>& ob)
+{
+	return ob.end;
+}
+
+template<output_stream Ohandler,std::size_t buffer_size,typename Allocator>
+inline constexpr void obuffer_set_curr(basic_direct_obuf<Ohandler,buffer_size,Allocator>& ob,typename Ohandler::char_type* ptr)
+{
+	ob.curr=ptr;
+}
+
+template<output_stream Ohandler,std::size_t buffer_size,typename Allocator>
+inline void overflow(basic_direct_obuf<Ohandler,buffer_size,Allocator>& ob,typename Ohandler::char_type ch)
+{
+	ob.commit_blocks();
+	*ob.curr=ch;
+	++ob.curr;
+}
+
+template<output_stream Ohandler,std::size_t buffer_size,typename Allocator,std::contiguous_iterator Iter>
+requires (write_read_punned_constraints<basic_direct_obuf<Ohandler,buffer_size,Allocator>,Iter>)
+inline void write(basic_direct_obuf<Ohandler,buffer_size,Allocator>& ob,Iter cbegini,Iter cendi)
+{
+	using char_type = typename Ohandler::char_type;
+	char_type const* first;
+	char_type const* last;
+	if constexpr(std::same_as<char_type,std::iter_value_t<Iter>>)
+	{
+		first=std::to_address(cbegini);
+		last=std::to_address(cendi);
+	}
+	else
+	{
+		first=reinterpret_cast<char_type const*>(std::to_address(cbegini));
+		last=reinterpret_cast<char_type const*>(std::to_address(cendi));
+	}
+	for(std::size_t n(last-first);;)
+	{
+		std::size_t const remain(ob.end-ob.curr);
+		if(n<remain)[[likely]]
+		{
+			memcpy(ob.curr,first,n*sizeof(char_type));
+			ob.curr+=n;
+			return;
+		}
+		memcpy(ob.curr,first,remain*sizeof(char_type));
+		ob.curr=ob.end;
+		first+=remain;
+		n-=remain;
+		ob.commit_blocks();
+	}
+}
+
+template<output_stream Ohandler,std::size_t buffer_size,typename Allocator>
+inline void flush(basic_direct_obuf<Ohandler,buffer_size,Allocator>& ob)
+{
+	ob.sync_impl();
+}
+
+template<input_stream Ihandler,std::size_t buffer_size = details::cal_buffer_size<typename Ihandler::char_type,true>(),
+	typename Allocator = io_aligned_allocator<typename Ihandler::char_type>>
+requires (buffer_size!=0)
+class basic_direct_ibuf
+{
+public:
+	using native_handle_type = Ihandler;
+	using char_type = typename Ihandler::char_type;
+	using allocator_type = Allocator;
+	Ihandler ih;
+	char_type *beg{},*curr{},*end{};
+private:
+	Allocator alloc;
+	std::size_t capacity{};
+	bool eof{};
+public:
+	template<typename... Args>
+	requires std::constructible_from<Ihandler,Args...>
+	basic_direct_ibuf(Args&&... args):ih(std::forward<Args>(args)...)
+	{
+		capacity=details::direct_io_round_up(buffer_size,details::direct_io_block_size<char_type>(ih));
+		end=curr=beg=std::allocator_traits<allocator_type>::allocate(alloc,capacity);
+	}
+	basic_direct_ibuf(basic_direct_ibuf const&)=delete;
+	basic_direct_ibuf& operator=(basic_direct_ibuf const&)=delete;
+	~basic_direct_ibuf()
+	{
+		std::allocator_traits<allocator_type>::deallocate(alloc,beg,capacity);
+	}
+	inline constexpr auto& native_handle() noexcept
+	{
+		return ih;
+	}
+//A short read on an O_DIRECT file only happens at end of file. Later reads would be misaligned, so stop there.
+	bool next_buffer()
+	{
+		if(eof)
+		{
+			curr=end;
+			return false;
+		}
+		auto it{beg};
+		for(auto last{beg+capacity};it!=last;)
+		{
+			auto ed{read(ih,it,last)};
+			if(ed==it)
+			{
+				eof=true;
+				break;
+			}
+			it=ed;
+			if(it!=last)
+			{
+				eof=true;
+				break;
+			}
+		}
+		curr=beg;
+		end=it;
+		return beg!=end;
+	}
+};
+
+template<input_stream Ihandler,std::size_t buffer_size,typename Allocator>
+[[nodiscard]] inline constexpr auto ibuffer_begin(basic_direct_ibuf<Ihandler,buffer_size,Allocator>& ib)
+{
+	return ib.beg;
+}
+
+template<input_stream Ihandler,std::size_t buffer_size,typename Allocator>
+[[nodiscard]] inline constexpr auto ibuffer_curr(basic_direct_ibuf<Ihandler,buffer_size,Allocator>& ib)
+{
+	return ib.curr;
+}
+
+template<input_stream Ihandler,std::size_t buffer_size,typename Allocator>
+[[nodiscard]] inline constexpr auto ibuffer_end(basic_direct_ibuf<Ihandler,buffer_size,Allocator>& ib)
+{
+	return ib.end;
+}
+
+template<input_stream Ihandler,std::size_t buffer_size,typename Allocator>
+inline constexpr void ibuffer_set_curr(basic_direct_ibuf<Ihandler,buffer_size,Allocator>& ib,typename Ihandler::char_type* ptr)
+{
+	ib.curr=ptr;
+}
+
+template<input_stream Ihandler,std::size_t buffer_size,typename Allocator>
+inline bool underflow(basic_direct_ibuf<Ihandler,buffer_size,Allocator>& ib)
+{
+	return ib.next_buffer();
+}
+
+template<input_stream Ihandler,std::size_t buffer_size,typename Allocator,std::contiguous_iterator Iter>
+requires (write_read_punned_constraints<basic_direct_ibuf<Ihandler,buffer_size,Allocator>,Iter>)
+inline Iter read(basic_direct_ibuf<Ihandler,buffer_size,Allocator>& ib,Iter begin,Iter end)
+{
+	using char_type = typename Ihandler::char_type;
+	char_type* first;
+	char_type* last;
+	if constexpr(std::same_as<char_type,std::iter_value_t<Iter>>)
+	{
+		first=std::to_address(begin);
+		last=std::to_address(end);
+	}
+	else
+	{
+		first=reinterpret_cast<char_type*>(std::to_address(begin));
+		last=reinterpret_cast<char_type*>(std::to_address(end));
+	}
+	if(ib.curr==ib.end&&!ib.next_buffer())
+		return begin;
+	std::size_t n(last-first);
+	std::size_t const remain(ib.end-ib.curr);
+	if(remain<n)
+		n=remain;
+	memcpy(first,ib.curr,n*sizeof(char_type));
+	ib.curr+=n;
+	return begin+n*sizeof(char_type)/sizeof(*begin);
+}
+
+}
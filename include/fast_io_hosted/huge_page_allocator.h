@@ -0,0 +1,176 @@
+#pragma once
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fast_io
+{
+
+/*
+io_huge_page_allocator backs large buffers with huge pages to cut dTLB misses when streaming at memory speed.
+Requests of at least threshold bytes are rounded up to whole huge pages and mapped anonymously. MAP_HUGETLB is tried
+first. When no hugetlbfs pages are reserved, it falls back to a huge page aligned mapping advised with
+MADV_HUGEPAGE, which transparent huge pages can back. Smaller requests go through io_aligned_allocator.
+The path is chosen from the size alone, so deallocate always takes the same path as allocate.
+The huge page size is read once at run time: hpage_pmd_size of transparent huge pages first, then Hugepagesize in
+/proc/meminfo, and 2 MiB when neither can be read. A threshold of 0 means one huge page.
+basic_huge_page_buf_handler keeps the ordinary buffer size unless a larger one is asked for. Only such buffers reach the
+threshold, so every stream that wants a huge page buffer opts in with its size.
+*/
+
+namespace details
+{
+
+inline std::size_t huge_page_read_file(char const* path,char* buffer,std::size_t size) noexcept
+{
+	int fd{::open(path,O_RDONLY|O_CLOEXEC)};
+	if(fd==-1)
+		return 0;
+	std::size_t n{};
+	for(ssize_t r;n!=size&&(r=::read(fd,buffer+n,size-n))>0;)
+		n+=static_cast<std::size_t>(r);
+	::close(fd);
+	return n;
+}
+
+inline std::size_t huge_page_parse_size(char const* p,char const* e) noexcept
+{
+	for(;p!=e&&(*p<'0'||'9'<*p);++p);
+	std::size_t v{};
+	for(;p!=e&&'0'<=*p&&*p<='9';++p)
+		v=v*10+static_cast<std::size_t>(*p-'0');
+	return v;
+}
+
+inline std::size_t huge_page_size_detect() noexcept
+{
+	char buffer[4096];
+	if(std::size_t n{huge_page_read_file("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size",buffer,sizeof(buffer))};n)
+	{
+		std::size_t const v{huge_page_parse_size(buffer,buffer+n)};
+		if(v&&(v&(v-1))==0)
+			return v;
+	}
+	if(std::size_t n{huge_page_read_file("/proc/meminfo",buffer,sizeof(buffer))};n)
+	{
+		constexpr std::string_view key{"Hugepagesize:"};
+		std::string_view const text(buffer,n);
+		if(auto pos{text.find(key)};pos!=std::string_view::npos)
+		{
+			auto const first{buffer+pos+key.size()};
+			std::size_t const v{huge_page_parse_size(first,std::find(first,buffer+n,'\n'))<<10};
+			if(v&&(v&(v-1))==0)
+				return v;
+		}
+	}
+	return 2097152;
+}
+
+inline std::size_t huge_page_size() noexcept
+{
+	static std::size_t const size{huge_page_size_detect()};
+	return size;
+}
+
+inline std::size_t huge_page_round_up(std::size_t bytes) noexcept
+{
+	std::size_t const page{huge_page_size()};
+	return (bytes+(page-1))&~(page-1);
+}
+
+inline void* huge_page_map(std::size_t bytes)
+{
+	std::size_t const huge_page_size{details::huge_page_size()};
+#if defined(MAP_HUGETLB)
+	if(auto p{mmap(nullptr,bytes,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB,-1,0)};p!=MAP_FAILED)
+		return p;
+#endif
+//over map by one huge page and trim both ends so the region starts on a huge page boundary
+	std::size_t const mapped{bytes+huge_page_size};
+	auto p{static_cast<std::byte*>(mmap(nullptr,mapped,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0))};
+	if(p==MAP_FAILED)
+		throw std::bad_alloc();
+	std::size_t const head{(huge_page_size-(std::bit_cast<std::uintptr_t>(p)&(huge_page_size-1)))&(huge_page_size-1)};
+	if(head)
+		munmap(p,head);
+	if(std::size_t const tail{huge_page_size-head};tail)
+		munmap(p+head+bytes,tail);
+	p+=head;
+#if defined(MADV_HUGEPAGE)
+	madvise(p,bytes,MADV_HUGEPAGE);
+#endif
+	return p;
+}
+}
+
+template<typename T,std::size_t threshold=0>
+struct io_huge_page_allocator
+{
+	static inline std::size_t threshold_bytes() noexcept
+	{
+		if constexpr(threshold==0)
+			return details::huge_page_size();
+		else
+			return threshold;
+	}
+	using value_type = T;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	template<typename U>
+	struct rebind
+	{
+		using other = io_huge_page_allocator<U,threshold>;
+	};
+	constexpr io_huge_page_allocator() noexcept = default;
+	template<typename U>
+	constexpr io_huge_page_allocator(io_huge_page_allocator<U,threshold> const&) noexcept{}
+	[[nodiscard]] inline
+	#if __cpp_lib_is_constant_evaluated >= 201811L && __cpp_constexpr_dynamic_alloc >= 201907L
+		constexpr
+	#endif
+	T* allocate(std::size_t n)
+	{
+	#if __cpp_lib_is_constant_evaluated >= 201811L && __cpp_constexpr_dynamic_alloc >= 201907L
+		if(std::is_constant_evaluated())
+			return new T[n];
+		else
+	#endif
+		{
+			std::size_t const bytes{n*sizeof(T)};
+			if(bytes<threshold_bytes())
+				return io_aligned_allocator<T>{}.allocate(n);
+			return static_cast<T*>(details::huge_page_map(details::huge_page_round_up(bytes)));
+		}
+	}
+	inline
+	#if __cpp_lib_is_constant_evaluated >= 201811L && __cpp_constexpr_dynamic_alloc >= 201907L
+		constexpr
+	#endif
+	void deallocate(T* p,std::size_t n) noexcept
+	{
+	#if __cpp_lib_is_constant_evaluated >= 201811L && __cpp_constexpr_dynamic_alloc >= 201907L
+		if(std::is_constant_evaluated())
+			delete[] p;
+		else
+	#endif
+		{
+			if(p==nullptr)
+				return;
+			std::size_t const bytes{n*sizeof(T)};
+			if(bytes<threshold_bytes())
+				io_aligned_allocator<T>{}.deallocate(p,n);
+			else
+				munmap(p,details::huge_page_round_up(bytes));
+		}
+	}
+	template<typename U>
+	inline constexpr bool operator==(io_huge_page_allocator<U,threshold> const&) const noexcept
+	{
+		return true;
+	}
+};
+
+template<std::integral CharT,bool need_secure_clear=false,std::size_t buffer_size = details::cal_buffer_size<CharT,true>()>
+using basic_huge_page_buf_handler = basic_buf_handler<CharT,need_secure_clear,buffer_size,io_huge_page_allocator<CharT>>;
+
+}
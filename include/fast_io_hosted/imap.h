@@ -0,0 +1,214 @@
+#pragma once
+
+namespace fast_io
+{
+
+/*
+basic_imap maps the whole file read only and exposes it as one contiguous buffer. scan, skip_line and igenerator run
+over it with no read calls, and underflow never succeeds.
+basic_imap_window maps a fixed size window instead and slides it forward on underflow, for files larger than the
+address space a process can spare.
+*/
+
+namespace details
+{
+template<typename T>
+inline std::size_t imap_file_size(T& hd)
+{
+	struct stat st;
+	if(::fstat(static_cast<basic_posix_io_observer<typename T::char_type>>(hd).fd,std::addressof(st))==-1)
+		throw_posix_error();
+	if(static_cast<std::uintmax_t>(SIZE_MAX)<static_cast<std::uintmax_t>(st.st_size))
+		throw_posix_error(EFBIG);
+	return static_cast<std::size_t>(st.st_size);
+}
+
+inline void imap_advise(std::span<std::byte> rg) noexcept
+{
+	if(rg.empty())
+		return;
+	::madvise(rg.data(),rg.size(),MADV_SEQUENTIAL);
+	::madvise(rg.data(),rg.size(),MADV_WILLNEED);
+}
+}
+
+template<input_stream T,typename M=native_file_map>
+class basic_imap
+{
+public:
+	using native_handle_type = T;
+	using map_handle_type = M;
+	using char_type = typename T::char_type;
+private:
+	native_handle_type hd;
+	std::optional<map_handle_type> fm;
+public:
+	char_type const *beg{},*curr{},*end{};
+	template<typename ...Args>
+	requires std::constructible_from<native_handle_type,Args...>
+	basic_imap(Args&& ...args):hd(std::forward<Args>(args)...)
+	{
+		std::size_t const bytes{details::imap_file_size(hd)/sizeof(char_type)*sizeof(char_type)};
+		if(bytes==0)
+			return;
+		fm.emplace(hd,file_map_attribute::read_only,bytes);
+		auto& rg{fm->region()};
+		details::imap_advise(rg);
+		end=(curr=beg=reinterpret_cast<char_type const*>(rg.data()))+bytes/sizeof(char_type);
+	}
+	basic_imap(basic_imap const&)=delete;
+	basic_imap& operator=(basic_imap const&)=delete;
+	auto& native_handle() noexcept
+	{
+		return hd;
+	}
+};
+
+template<input_stream T,typename M>
+inline constexpr auto ibuffer_begin(basic_imap<T,M>& im) noexcept
+{
+	return im.beg;
+}
+
+template<input_stream T,typename M>
+inline constexpr auto ibuffer_curr(basic_imap<T,M>& im) noexcept
+{
+	return im.curr;
+}
+
+template<input_stream T,typename M>
+inline constexpr auto ibuffer_end(basic_imap<T,M>& im) noexcept
+{
+	return im.end;
+}
+
+template<input_stream T,typename M>
+inline constexpr void ibuffer_set_curr(basic_imap<T,M>& im,typename T::char_type const* ptr) noexcept
+{
+	im.curr=ptr;
+}
+
+template<input_stream T,typename M>
+inline constexpr bool underflow(basic_imap<T,M>&) noexcept
+{
+	return false;
+}
+
+template<input_stream T,typename M>
+inline constexpr void underflow_forever_false(basic_imap<T,M>&) noexcept{}
+
+template<input_stream T,typename M,std::contiguous_iterator Iter>
+requires (write_read_punned_constraints<basic_imap<T,M>,Iter>)
+inline Iter read(basic_imap<T,M>& im,Iter begin,Iter end)
+{
+	using char_type = typename T::char_type;
+	std::size_t n(static_cast<std::size_t>(end-begin)*sizeof(*begin)/sizeof(char_type));
+	std::size_t const remain(im.end-im.curr);
+	if(remain<n)
+		n=remain;
+	memcpy(std::to_address(begin),im.curr,n*sizeof(char_type));
+	im.curr+=n;
+	return begin+n*sizeof(char_type)/sizeof(*begin);
+}
+
+template<input_stream T,typename M=native_file_map,std::size_t window_size=67108864>
+requires (window_size!=0&&window_size%65536==0)
+class basic_imap_window
+{
+public:
+	using native_handle_type = T;
+	using map_handle_type = M;
+	using char_type = typename T::char_type;
+	static_assert(window_size%sizeof(char_type)==0);
+private:
+	native_handle_type hd;
+	std::optional<map_handle_type> fm;
+	std::size_t file_size{};
+	std::size_t window_start{};
+public:
+	char_type const *beg{},*curr{},*end{};
+	template<typename ...Args>
+	requires std::constructible_from<native_handle_type,Args...>
+	basic_imap_window(Args&& ...args):hd(std::forward<Args>(args)...),
+		file_size(details::imap_file_size(hd)/sizeof(char_type)*sizeof(char_type))
+	{
+		map_window(0);
+	}
+	basic_imap_window(basic_imap_window const&)=delete;
+	basic_imap_window& operator=(basic_imap_window const&)=delete;
+	auto& native_handle() noexcept
+	{
+		return hd;
+	}
+//map [start,start+window_size) of the file. Returns false at end of file.
+	bool map_window(std::size_t start)
+	{
+		fm.reset();
+		beg=curr=end=nullptr;
+		window_start=start;
+		if(file_size<=start)
+			return false;
+		std::size_t bytes{file_size-start};
+		if(window_size<bytes)
+			bytes=window_size;
+		fm.emplace(hd,file_map_attribute::read_only,bytes,start);
+		auto& rg{fm->region()};
+		details::imap_advise(rg);
+		end=(curr=beg=reinterpret_cast<char_type const*>(rg.data()))+bytes/sizeof(char_type);
+		return true;
+	}
+	bool next_window()
+	{
+		if(beg==nullptr)
+			return false;
+		return map_window(window_start+window_size);
+	}
+};
+
+template<input_stream T,typename M,std::size_t window_size>
+inline constexpr auto ibuffer_begin(basic_imap_window<T,M,window_size>& im) noexcept
+{
+	return im.beg;
+}
+
+template<input_stream T,typename M,std::size_t window_size>
+inline constexpr auto ibuffer_curr(basic_imap_window<T,M,window_size>& im) noexcept
+{
+	return im.curr;
+}
+
+template<input_stream T,typename M,std::size_t window_size>
+inline constexpr auto ibuffer_end(basic_imap_window<T,M,window_size>& im) noexcept
+{
+	return im.end;
+}
+
+template<input_stream T,typename M,std::size_t window_size>
+inline constexpr void ibuffer_set_curr(basic_imap_window<T,M,window_size>& im,typename T::char_type const* ptr) noexcept
+{
+	im.curr=ptr;
+}
+
+template<input_stream T,typename M,std::size_t window_size>
+inline bool underflow(basic_imap_window<T,M,window_size>& im)
+{
+	return im.next_window();
+}
+
+template<input_stream T,typename M,std::size_t window_size,std::contiguous_iterator Iter>
+requires (write_read_punned_constraints<basic_imap_window<T,M,window_size>,Iter>)
+inline Iter read(basic_imap_window<T,M,window_size>& im,Iter begin,Iter end)
+{
+	using char_type = typename T::char_type;
+	if(im.curr==im.end&&!im.next_window())
+		return begin;
+	std::size_t n(static_cast<std::size_t>(end-begin)*sizeof(*begin)/sizeof(char_type));
+	std::size_t const remain(im.end-im.curr);
+	if(remain<n)
+		n=remain;
+	memcpy(std::to_address(begin),im.curr,n*sizeof(char_type));
+	im.curr+=n;
+	return begin+n*sizeof(char_type)/sizeof(*begin);
+}
+
+}
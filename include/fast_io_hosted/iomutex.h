@@ -1,92 +1,556 @@
 #pragma once
 #include <mutex>
+#include <memory>
+#include <vector>
+#include <atomic>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if __has_include(<sys/single_threaded.h>)
+#include <sys/single_threaded.h>
+#endif
+#endif
 
 namespace fast_io
 {
 
-template<stream T>
+/*
+io_mutex is a 4 byte lock meant for the short critical sections of stream calls. It lives inside the stream, so there
+is no allocation and no indirection. The state is 0 when unlocked, 1 when locked and 2 when there may be sleepers.
+A contended lock spins for a while before it sleeps on a futex (std::atomic wait outside Linux), and unlock only makes
+a system call when someone sleeps. Like glibc's own mutex, it skips the locked instructions while the process has a
+single thread.
+*/
+
+namespace details
+{
+inline void io_mutex_pause() noexcept
+{
+#if (defined(__GNUC__)||defined(__clang__))&&(defined(__x86_64__)||defined(__i386__))
+	__builtin_ia32_pause();
+#elif (defined(__GNUC__)||defined(__clang__))&&defined(__aarch64__)
+	__asm__ __volatile__("yield");
+#endif
+}
+}
+
+class io_mutex
+{
+	std::atomic<std::uint32_t> state{};
+	static_assert(sizeof(std::atomic<std::uint32_t>)==sizeof(std::uint32_t));
+	void sleep() noexcept
+	{
+#if defined(__linux__)
+		::syscall(SYS_futex,std::addressof(state),FUTEX_WAIT_PRIVATE,2,nullptr,nullptr,0);
+#else
+		state.wait(2,std::memory_order_relaxed);
+#endif
+	}
+	void wake() noexcept
+	{
+#if defined(__linux__)
+		::syscall(SYS_futex,std::addressof(state),FUTEX_WAKE_PRIVATE,1,nullptr,nullptr,0);
+#else
+		state.notify_one();
+#endif
+	}
+	void lock_slow(std::uint32_t c) noexcept
+	{
+		for(std::size_t spins{};spins!=128&&c!=2;++spins)
+		{
+			details::io_mutex_pause();
+			c=state.load(std::memory_order_relaxed);
+			if(c==0&&state.compare_exchange_weak(c,1,std::memory_order_acquire,std::memory_order_relaxed))
+				return;
+		}
+		if(c!=2)
+			c=state.exchange(2,std::memory_order_acquire);
+		while(c!=0)
+		{
+			sleep();
+			c=state.exchange(2,std::memory_order_acquire);
+		}
+	}
+public:
+	constexpr io_mutex() noexcept=default;
+	io_mutex(io_mutex const&)=delete;
+	io_mutex& operator=(io_mutex const&)=delete;
+	bool try_lock() noexcept
+	{
+		std::uint32_t c{};
+		return state.compare_exchange_strong(c,1,std::memory_order_acquire,std::memory_order_relaxed);
+	}
+	void lock() noexcept
+	{
+#if defined(__linux__)&&__has_include(<sys/single_threaded.h>)
+		if(__libc_single_threaded&&state.load(std::memory_order_relaxed)==0)
+		{
+			state.store(1,std::memory_order_relaxed);
+			return;
+		}
+#endif
+		std::uint32_t c{};
+		if(state.compare_exchange_strong(c,1,std::memory_order_acquire,std::memory_order_relaxed))[[likely]]
+			return;
+		lock_slow(c);
+	}
+	void unlock() noexcept
+	{
+#if defined(__linux__)&&__has_include(<sys/single_threaded.h>)
+//no other thread exists, so none can sleep on the lock
+		if(__libc_single_threaded)
+		{
+			state.store(0,std::memory_order_relaxed);
+			return;
+		}
+#endif
+		if(state.exchange(0,std::memory_order_release)==2)[[unlikely]]
+			wake();
+	}
+};
+
+template<stream T,typename Mutex=io_mutex>
 class basic_iomutex
 {
-	std::unique_ptr<std::mutex> mtx;
+	Mutex mtx;
 	T handler;
 public:
 	using native_handle_type = T;
-	using lock_guard_type = std::lock_guard<std::mutex>;
+	using mutex_type = Mutex;
+	using lock_guard_type = std::lock_guard<Mutex>;
 	using char_type = typename native_handle_type::char_type;
 	template<typename ...Args>
 	requires std::constructible_from<T,Args...>
-	basic_iomutex(Args&& ...args):mtx(std::make_unique<std::mutex>()),handler(std::forward<Args>(args)...){}
+	basic_iomutex(Args&& ...args):handler(std::forward<Args>(args)...){}
+	basic_iomutex(basic_iomutex&& o) noexcept(std::is_nothrow_move_constructible_v<T>):handler(std::move(o.handler)){}
+	basic_iomutex& operator=(basic_iomutex&& o) noexcept(std::is_nothrow_move_assignable_v<T>)
+	{
+		handler=std::move(o.handler);
+		return *this;
+	}
 	native_handle_type& native_handle()
 	{
 		return handler;
 	}
-	std::mutex& mutex()
+	Mutex& mutex()
 	{
-		return *mtx;
+		return mtx;
 	}
+//the mutexes stay where they are. Neither stream may be locked.
 	void swap(basic_iomutex& o) noexcept
 	{
 		using std::swap;
-		swap(mtx,o.mtx);
 		swap(handler,o.handler);
 	}
 };
 
-template<stream T>
-inline auto& mutex(basic_iomutex<T>& t)
+template<stream T,typename Mutex>
+inline auto& mutex(basic_iomutex<T,Mutex>& t)
 {
 	return t.mutex();
 }
 
-template<stream T>
-inline auto& unlocked_handle(basic_iomutex<T>& t)
+template<stream T,typename Mutex>
+inline auto& unlocked_handle(basic_iomutex<T,Mutex>& t)
 {
 	return t.native_handle();
 }
 
-template<output_stream T,std::contiguous_iterator Iter>
-inline auto write(basic_iomutex<T>& t,Iter b,Iter e)
+template<output_stream T,typename Mutex,std::contiguous_iterator Iter>
+inline auto write(basic_iomutex<T,Mutex>& t,Iter b,Iter e)
 {
 	std::lock_guard lg(t.mutex());
 	return write(t.native_handle(),b,e);
 }
 
-template<output_stream T>
-inline void flush(basic_iomutex<T>& t)
+template<output_stream T,typename Mutex>
+inline void flush(basic_iomutex<T,Mutex>& t)
 {
 	std::lock_guard lg(t.mutex());
 	flush(t.native_handle());
 }
-template<input_stream T,std::contiguous_iterator Iter>
-inline Iter read(basic_iomutex<T>& t,Iter begin,Iter end)
+template<input_stream T,typename Mutex,std::contiguous_iterator Iter>
+inline Iter read(basic_iomutex<T,Mutex>& t,Iter begin,Iter end)
 {
 	std::lock_guard lg(t.mutex());
 	return read(t.native_handle(),begin,end);
 }
 
 
-template<random_access_stream T,typename... Args>
-inline auto seek(basic_iomutex<T>& t,Args&& ...args)
+template<random_access_stream T,typename Mutex,typename... Args>
+inline auto seek(basic_iomutex<T,Mutex>& t,Args&& ...args)
 {
 	std::lock_guard lg(t.mutex());
 	return seek(t.native_handle(),std::forward<Args>(args)...);
 }
 
-template<character_output_stream output>
-inline void fill_nc(basic_iomutex<output>& out,std::size_t count,typename output::char_type const& ch)
+template<character_output_stream output,typename Mutex>
+inline void fill_nc(basic_iomutex<output,Mutex>& out,std::size_t count,typename output::char_type const& ch)
 {
 	std::lock_guard lg{out.mutex()};
 	fill_nc(out.native_handle(),count,ch);
 }
 
-template<stream T>
-inline void swap(basic_iomutex<T>& a,basic_iomutex<T>& b) noexcept
+template<stream T,typename Mutex>
+inline void swap(basic_iomutex<T,Mutex>& a,basic_iomutex<T,Mutex>& b) noexcept
 {
 	a.swap(b);
 }
-template<redirect_stream T>
-inline constexpr decltype(auto) redirect_handle(basic_iomutex<T>& t)
+template<redirect_stream T,typename Mutex>
+inline constexpr decltype(auto) redirect_handle(basic_iomutex<T,Mutex>& t)
 {
 	return redirect_handle(t.native_handle());
 }
+
+/*
+basic_batched_iomutex lets many threads print to one sink without fighting over a lock on every call. Every thread
+prints into a buffer of its own, and one print or println always lands there as a whole record. When a thread starts
+a record while its buffer holds batch_size or more, the buffer goes to the sink in one write under the shared mutex.
+Records never interleave, records of one thread keep their order, and the shared mutex is taken once per batch.
+flush commits the buffers of every thread and flushes the sink. Every buffer has a lock of its own that its thread holds
+for one record, so flush takes a buffer between two records. Buffers are also committed when they fill up, when their
+thread exits and when the stream is destroyed. The buffer of an exited thread goes to a free list
+and serves the next thread that starts printing, so the stream holds no more buffers than threads ever printed to it
+at the same time.
+*/
+
+namespace details
+{
+
+template<std::integral ch_type>
+class iomutex_batch_buffer
+{
+public:
+	using char_type = ch_type;
+	char_type *beg{},*curr{},*end{};
+//held by the owning thread while it writes a record, and by flush while it commits the buffer
+	io_mutex mtx;
+	constexpr iomutex_batch_buffer() noexcept=default;
+	iomutex_batch_buffer(iomutex_batch_buffer const&)=delete;
+	iomutex_batch_buffer& operator=(iomutex_batch_buffer const&)=delete;
+	~iomutex_batch_buffer()
+	{
+		if(beg)
+			io_aligned_allocator<char_type>{}.deallocate(beg,static_cast<std::size_t>(end-beg));
+	}
+	void grow(std::size_t n)
+	{
+		std::size_t const used(curr-beg);
+		std::size_t new_capacity(static_cast<std::size_t>(end-beg)<<1);
+		if(new_capacity<used+n)
+			new_capacity=used+n;
+		if(new_capacity<4096)
+			new_capacity=4096;
+		auto new_buffer{io_aligned_allocator<char_type>{}.allocate(new_capacity)};
+		if(beg)
+		{
+			memcpy(new_buffer,beg,used*sizeof(char_type));
+			io_aligned_allocator<char_type>{}.deallocate(beg,static_cast<std::size_t>(end-beg));
+		}
+		beg=new_buffer;
+		curr=new_buffer+used;
+		end=new_buffer+new_capacity;
+	}
+};
+
+template<std::integral char_type>
+inline constexpr char_type* obuffer_begin(iomutex_batch_buffer<char_type>& b) noexcept
+{
+	return b.beg;
+}
+
+template<std::integral char_type>
+inline constexpr char_type* obuffer_curr(iomutex_batch_buffer<char_type>& b) noexcept
+{
+	return b.curr;
+}
+
+template<std::integral char_type>
+inline constexpr char_type* obuffer_end(iomutex_batch_buffer<char_type>& b) noexcept
+{
+	return b.end;
+}
+
+template<std::integral char_type>
+inline constexpr void obuffer_set_curr(iomutex_batch_buffer<char_type>& b,char_type* ptr) noexcept
+{
+	b.curr=ptr;
+}
+
+template<std::integral char_type>
+inline void overflow(iomutex_batch_buffer<char_type>& b,char_type ch)
+{
+	b.grow(1);
+	*b.curr=ch;
+	++b.curr;
+}
+
+template<std::integral char_type,std::contiguous_iterator Iter>
+requires (std::same_as<char_type,std::iter_value_t<Iter>>||std::same_as<char,char_type>)
+inline void write(iomutex_batch_buffer<char_type>& b,Iter cbegin,Iter cend)
+{
+	if constexpr(std::same_as<char_type,std::iter_value_t<Iter>>)
+	{
+		std::size_t const n(cend-cbegin);
+		if(static_cast<std::size_t>(b.end-b.curr)<n)
+			b.grow(n);
+		non_overlapped_copy_n(std::to_address(cbegin),n,b.curr);
+		b.curr+=n;
+	}
+	else
+		write(b,reinterpret_cast<char const*>(std::to_address(cbegin)),
+			reinterpret_cast<char const*>(std::to_address(cend)));
+}
+
+//outlives the stream while a thread still caches it. stream becomes nullptr when the stream is destroyed.
+struct iomutex_batch_control
+{
+	io_mutex mtx;
+	void* stream{};
+//commits the buffer of an exiting thread and hands it back to the stream. Called with mtx held.
+	void (*retire)(void* stream,void* buffer){};
+};
+
+struct iomutex_batch_slot
+{
+	std::shared_ptr<iomutex_batch_control> control;
+	void* buffer{};
+};
+
+struct iomutex_batch_thread_cache
+{
+	iomutex_batch_control* last_control{};
+	void* last_buffer{};
+	std::vector<iomutex_batch_slot> slots;
+	iomutex_batch_thread_cache()=default;
+	iomutex_batch_thread_cache(iomutex_batch_thread_cache const&)=delete;
+	iomutex_batch_thread_cache& operator=(iomutex_batch_thread_cache const&)=delete;
+	~iomutex_batch_thread_cache()
+	{
+		for(auto& e : slots)
+		{
+			std::lock_guard lg{e.control->mtx};
+			if(e.control->stream==nullptr)
+				continue;
+#ifdef __cpp_exceptions
+			try
+			{
+#endif
+				e.control->retire(e.control->stream,e.buffer);
+#ifdef __cpp_exceptions
+			}
+			catch(...)
+			{
+			}
+#endif
+		}
+	}
+};
+
+inline thread_local iomutex_batch_thread_cache iomutex_batch_cache;
+
+template<typename stream_type>
+struct iomutex_batch_record_guard
+{
+	typename stream_type::buffer_type& buffer;
+	explicit iomutex_batch_record_guard(stream_type& t):buffer(t.local())
+	{
+		buffer.mtx.lock();
+#ifdef __cpp_exceptions
+		try
+		{
+#endif
+			t.begin_record(buffer);
+#ifdef __cpp_exceptions
+		}
+		catch(...)
+		{
+			buffer.mtx.unlock();
+			throw;
+		}
+#endif
+	}
+	iomutex_batch_record_guard(iomutex_batch_record_guard const&)=delete;
+	iomutex_batch_record_guard& operator=(iomutex_batch_record_guard const&)=delete;
+	~iomutex_batch_record_guard()
+	{
+		buffer.mtx.unlock();
+	}
+};
+
+}
+
+template<output_stream T,std::size_t batch_size=65536>
+class basic_batched_iomutex
+{
+public:
+	using native_handle_type = T;
+	using char_type = typename native_handle_type::char_type;
+	using buffer_type = details::iomutex_batch_buffer<char_type>;
+//print and println take this as their lock. It only commits the batch of the calling thread when it is full.
+	using lock_guard_type = details::iomutex_batch_record_guard<basic_batched_iomutex>;
+private:
+	std::shared_ptr<details::iomutex_batch_control> control;
+	std::vector<std::unique_ptr<buffer_type>> buffers;
+//buffers of exited threads. Its capacity always covers every buffer, so retiring never allocates.
+	std::vector<buffer_type*> free_buffers;
+	T handler;
+	static void commit_locked(void* stream,void* buffer)
+	{
+		auto& b{*static_cast<buffer_type*>(buffer)};
+		if(b.curr==b.beg)
+			return;
+		write_all(static_cast<basic_batched_iomutex*>(stream)->handler,b.beg,b.curr);
+		b.curr=b.beg;
+	}
+	static void retire_locked(void* stream,void* buffer)
+	{
+		static_cast<basic_batched_iomutex*>(stream)->free_buffers.push_back(static_cast<buffer_type*>(buffer));
+		commit_locked(stream,buffer);
+	}
+	buffer_type& local_slow()
+	{
+		auto& cache{details::iomutex_batch_cache};
+		for(auto& e : cache.slots)
+			if(e.control==control)
+			{
+				cache.last_control=e.control.get();
+				return *static_cast<buffer_type*>(cache.last_buffer=e.buffer);
+			}
+		std::erase_if(cache.slots,[](details::iomutex_batch_slot const& e)
+		{
+			std::lock_guard lg{e.control->mtx};
+			return e.control->stream==nullptr;
+		});
+		cache.slots.reserve(cache.slots.size()+1);
+		buffer_type* b{};
+		{
+			std::lock_guard lg{control->mtx};
+			if(free_buffers.empty())
+			{
+				buffers.reserve(buffers.size()+1);
+				free_buffers.reserve(buffers.size()+1);
+				b=buffers.emplace_back(std::make_unique<buffer_type>()).get();
+			}
+			else
+			{
+				b=free_buffers.back();
+				free_buffers.pop_back();
+			}
+		}
+		cache.slots.push_back({control,b});
+		cache.last_control=control.get();
+		cache.last_buffer=b;
+		return *b;
+	}
+public:
+	template<typename ...Args>
+	requires std::constructible_from<T,Args...>
+	basic_batched_iomutex(Args&& ...args):control(std::make_shared<details::iomutex_batch_control>()),handler(std::forward<Args>(args)...)
+	{
+		control->stream=this;
+		control->retire=retire_locked;
+	}
+	basic_batched_iomutex(basic_batched_iomutex const&)=delete;
+	basic_batched_iomutex& operator=(basic_batched_iomutex const&)=delete;
+	~basic_batched_iomutex()
+	{
+		std::lock_guard lg{control->mtx};
+		control->stream=nullptr;
+#ifdef __cpp_exceptions
+		try
+		{
+#endif
+			for(auto& e : buffers)
+				commit_locked(this,e.get());
+#ifdef __cpp_exceptions
+		}
+		catch(...)
+		{
+		}
+#endif
+	}
+//the sink itself. Only safe to touch while no other thread uses the stream.
+	native_handle_type& native_handle() noexcept
+	{
+		return handler;
+	}
+	io_mutex& sink_mutex() noexcept
+	{
+		return control->mtx;
+	}
+//buffer of the calling thread
+	buffer_type& local()
+	{
+		auto& cache{details::iomutex_batch_cache};
+		if(cache.last_control==control.get())[[likely]]
+			return *static_cast<buffer_type*>(cache.last_buffer);
+		return local_slow();
+	}
+//called with the lock of b held
+	void begin_record(buffer_type& b)
+	{
+		if(batch_size<=static_cast<std::size_t>(b.curr-b.beg))
+			commit(b);
+	}
+	void commit(buffer_type& b)
+	{
+		if(b.curr==b.beg)
+			return;
+		std::lock_guard lg{control->mtx};
+		commit_locked(this,std::addressof(b));
+	}
+//commit the buffers of all threads. Buffers are never freed before the stream, so the pointers taken under the sink
+//lock stay valid. Each buffer is locked before the sink, in the order a record takes them.
+	void commit_all()
+	{
+		std::vector<buffer_type*> all;
+		{
+			std::lock_guard lg{control->mtx};
+			all.reserve(buffers.size());
+			for(auto& e : buffers)
+				all.push_back(e.get());
+		}
+		for(auto e : all)
+		{
+			std::lock_guard blg{e->mtx};
+			commit(*e);
+		}
+	}
+};
+
+template<output_stream T,std::size_t batch_size>
+inline auto& mutex(basic_batched_iomutex<T,batch_size>& t) noexcept
+{
+	return t;
+}
+
+template<output_stream T,std::size_t batch_size>
+inline auto& unlocked_handle(basic_batched_iomutex<T,batch_size>& t)
+{
+	return t.local();
+}
+
+template<output_stream T,std::size_t batch_size,std::contiguous_iterator Iter>
+inline void write(basic_batched_iomutex<T,batch_size>& t,Iter b,Iter e)
+{
+	typename basic_batched_iomutex<T,batch_size>::lock_guard_type lg{t};
+	write(lg.buffer,b,e);
+}
+
+template<output_stream T,std::size_t batch_size>
+inline void flush(basic_batched_iomutex<T,batch_size>& t)
+{
+	t.commit_all();
+	if constexpr(requires(T& h)
+	{
+		flush(h);
+	})
+	{
+		std::lock_guard lg{t.sink_mutex()};
+		flush(t.native_handle());
+	}
+}
+
 }
\ No newline at end of file
@@ -2,7 +2,11 @@
 
 namespace fast_io
 {
-template<typename T,typename M,std::size_t init_mem_size=UINT32_MAX>
+/*
+basic_omap starts with a small mapping and doubles it whenever a write does not fit. At close the file is truncated
+to the bytes actually written.
+*/
+template<typename T,typename M,std::size_t init_mem_size=1048576>
 class basic_omap
 {
 public:
@@ -80,7 +84,13 @@ inline std::size_t size(basic_omap<T,M>& om)
 template<typename T,typename M>
 inline void reserve(basic_omap<T,M>& om,std::size_t trunc)
 {
-	om.map_handle()=M(om.native_handle(),fast_io::file_map_attribute::read_write,trunc);
+	if constexpr(requires(M& m)
+	{
+		m.resize(om.native_handle(),fast_io::file_map_attribute::read_write,trunc);
+	})
+		om.map_handle().resize(om.native_handle(),fast_io::file_map_attribute::read_write,trunc);
+	else
+		om.map_handle()=M(om.native_handle(),fast_io::file_map_attribute::read_write,trunc);
 	if(trunc<om.current_position)
 		om.current_position=trunc;
 }
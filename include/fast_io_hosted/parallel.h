@@ -38,6 +38,9 @@ struct parallel_unit
 
 template<typename Func>
 inline constexpr manip::parallel_counter<Func> parallel_counter(Func func,std::size_t count,std::size_t chars_per_element){return {func,count,chars_per_element};}
+//without chars_per_element, output of any length is collected in segments
+template<typename Func>
+inline constexpr manip::parallel_counter<Func> parallel_counter(Func func,std::size_t count){return {func,count,0};}
 
 template<std::ranges::random_access_range T>
 inline constexpr manip::parallel<T,void> parallel(T& r){return {r};}
@@ -47,16 +50,109 @@ inline constexpr manip::parallel<T,Func> parallel(T& r,Func callback){return {r,
 template<typename Func>
 inline constexpr manip::parallel_unit<Func> parallel_unit(Func callback,std::size_t count){return {callback,count};}
 
-namespace details
+/*
+basic_parallel_segments is the output stream a parallel worker prints into when the output size is not known in
+advance. It fills blocks of a parallel_segment_pool and records every filled part as a segment. Output of the next
+chunk on the same worker continues in the same block.
+*/
+template<std::integral ch_type>
+class basic_parallel_segments
+{
+public:
+	using char_type = ch_type;
+	parallel_segment_pool* pool{};
+	char_type *beg{},*curr{},*end{};
+	explicit basic_parallel_segments(parallel_segment_pool& p) noexcept:pool(std::addressof(p)),
+		beg(reinterpret_cast<char_type*>(p.cursor)),curr(beg),end(reinterpret_cast<char_type*>(p.cursor_end)){}
+	basic_parallel_segments(basic_parallel_segments const&)=delete;
+	basic_parallel_segments& operator=(basic_parallel_segments const&)=delete;
+//record the filled part of the block as a segment and hand the rest of the block back to the pool
+	void seal()
+	{
+		if(curr!=beg)
+			pool->segments.push_back({beg,static_cast<std::size_t>(curr-beg)*sizeof(char_type)});
+		beg=curr;
+		pool->cursor=reinterpret_cast<std::byte*>(curr);
+		pool->cursor_end=reinterpret_cast<std::byte*>(end);
+	}
+	void next_block()
+	{
+		seal();
+		beg=curr=reinterpret_cast<char_type*>(pool->next_block());
+		end=beg+parallel_segment_pool::block_size/sizeof(char_type);
+	}
+};
+
+template<std::integral char_type>
+inline constexpr char_type* obuffer_begin(basic_parallel_segments<char_type>& segs) noexcept
+{
+	return segs.beg;
+}
+
+template<std::integral char_type>
+inline constexpr char_type* obuffer_curr(basic_parallel_segments<char_type>& segs) noexcept
+{
+	return segs.curr;
+}
+
+template<std::integral char_type>
+inline constexpr char_type* obuffer_end(basic_parallel_segments<char_type>& segs) noexcept
 {
-template<std::integral ch_type,typename Func>
-inline constexpr void print_out(fast_io::ospan<ch_type>* osp,Func func,std::size_t start_number,std::size_t stop_number)
+	return segs.end;
+}
+
+template<std::integral char_type>
+inline constexpr void obuffer_set_curr(basic_parallel_segments<char_type>& segs,char_type* ptr) noexcept
+{
+	segs.curr=ptr;
+}
+
+template<std::integral char_type>
+inline void overflow(basic_parallel_segments<char_type>& segs,char_type ch)
+{
+	segs.next_block();
+	*segs.curr=ch;
+	++segs.curr;
+}
+
+template<std::integral char_type,std::contiguous_iterator Iter>
+requires (std::same_as<char_type,std::iter_value_t<Iter>>||std::same_as<char,char_type>)
+inline void write(basic_parallel_segments<char_type>& segs,Iter cbegin,Iter cend)
 {
-	fast_io::ospan<ch_type> bas{*osp};
-	func(bas,start_number,stop_number);
-	*osp=bas;
+	if constexpr(std::same_as<char_type,std::iter_value_t<Iter>>)
+	{
+		auto first{std::to_address(cbegin)};
+		auto last{std::to_address(cend)};
+		for(;;)
+		{
+			std::size_t const n(last-first);
+			std::size_t const remain(segs.end-segs.curr);
+//a fresh segments stream has no block yet, and memcpy must not see its null pointers even for 0 bytes
+			if(n<=remain)
+			{
+				if(n)
+				{
+					details::non_overlapped_copy_n(first,n,segs.curr);
+					segs.curr+=n;
+				}
+				return;
+			}
+			if(remain)
+			{
+				details::non_overlapped_copy_n(first,remain,segs.curr);
+				first+=remain;
+				segs.curr=segs.end;
+			}
+			segs.next_block();
+		}
+	}
+	else
+		write(segs,reinterpret_cast<char const*>(std::to_address(cbegin)),
+			reinterpret_cast<char const*>(std::to_address(cend)));
 }
 
+namespace details
+{
 template<std::integral ch_type>
 struct span_raii
 {
@@ -69,17 +165,17 @@ struct span_raii
 	constexpr span_raii(span_raii const&)=delete;
 	constexpr span_raii(span_raii&& other) noexcept:osp(other.osp)
 	{
-		other.osp.span()={};
+		other.osp.span={};
 	}
 	constexpr span_raii& operator=(span_raii const&)=delete;
 	constexpr span_raii& operator=(span_raii&& other) noexcept
 	{
 		if(std::addressof(other)==this)
 			return *this;
-		if(osp.span().data())[[likely]]
+		if(osp.span.data())[[likely]]
 			delete[] osp.data();	
-		osp.span()=other.osp.span();
-		other.osp.span()={};
+		osp.span=other.osp.span;
+		other.osp.span={};
 		return *this;
 	}
 #if __cpp_constexpr >= 201907L
@@ -87,60 +183,112 @@ struct span_raii
 #endif
 	~span_raii()
 	{
-		if(osp.span().data())[[likely]]
-			delete[] osp.span().data();
+		if(osp.span.data())[[likely]]
+			delete[] osp.span.data();
 	}
 };
 
+struct parallel_chunk_result
+{
+	std::size_t worker{};
+	std::size_t first{};
+	std::size_t last{};
+};
+
+//write the chunks in order. Streams that can scatter, directly or through their native handle, get one writev.
+template<output_stream stm>
+inline void parallel_write_scatters(stm& output,io_scatter_t* first,io_scatter_t* last)
+{
+	if constexpr(scatter_output_stream<stm>)
+		scatter_write_all(output,first,last);
+	else if constexpr(buffer_output_stream<stm>&&requires(stm& out)
+	{
+		requires scatter_output_stream<std::remove_cvref_t<decltype(out.native_handle())>>;
+	})
+	{
+		flush(output);
+		scatter_write_all(output.native_handle(),first,last);
+	}
+	else
+	{
+		using char_type = typename stm::char_type;
+		for(;first!=last;++first)
+		{
+			auto p{static_cast<char_type const*>(first->base)};
+			write(output,p,p+first->len/sizeof(char_type));
+		}
+	}
+}
+
+/*
+The range is cut into more chunks than workers so that stealing can even out uneven chunks, then the chunks are
+written out in order.
+With chars_per_element, every chunk is printed into an ospan carved out of the scratch buffer of its worker.
+With chars_per_element==0 the size is unknown. Chunks are printed into basic_parallel_segments, which chains blocks
+of the worker's segment pool, and the segments are written without being concatenated.
+*/
 template<output_stream stm,typename Func>
 inline void parrallel_details_no_constexpr(stm& output,std::size_t count,std::size_t chars_per_element,Func& func)
 {
 	using char_type = typename stm::char_type;
-	std::size_t thread_number{std::thread::hardware_concurrency()};
-
-	if(thread_number<2)[[unlikely]]
+	auto& executor{parallel_executor::global()};
+	std::lock_guard lg{executor.session()};
+	std::size_t const workers{executor.concurrency()};
+	std::size_t chunks{workers<2?1:(workers<<2)};
+	if(count<chunks)
+		chunks=count;
+	if(chunks==0)
+		return;
+	std::size_t const range{count/chunks};
+	std::size_t const module{count%chunks};
+	std::vector<parallel_chunk_result> results(chunks);
+	std::vector<io_scatter_t> scatters;
+	executor.clear_scratches();
+	if(chars_per_element==0)
 	{
-		if constexpr(reserve_output_stream<stm>)
+		auto task{[&](std::size_t chunk,std::size_t worker)
 		{
-			func(output,0,count);
-		}
-		else
+			std::size_t const start_number{chunk*range+(chunk<module?chunk:module)};
+			std::size_t const stop_number{start_number+range+(chunk<module)};
+			auto& pool{executor.segment_pool(worker)};
+			std::size_t const first{pool.segments.size()};
+			basic_parallel_segments<char_type> segments{pool};
+			func(segments,start_number,stop_number);
+			segments.seal();
+			results[chunk]={worker,first,pool.segments.size()};
+		}};
+		executor.run(chunks,task);
+		std::size_t total{};
+		for(auto const& e : results)
+			total+=e.last-e.first;
+		scatters.reserve(total);
+		for(auto const& e : results)
 		{
-			std::size_t const total_chars{count*chars_per_element};
-			span_raii<char_type> osp{new char_type[total_chars],total_chars};
-			func(osp.osp,0,count);
-			write(output,osp.osp.span().data(),osp.osp.span().data()+osize(osp.osp));
+			auto const& segs{executor.segment_pool(e.worker).segments};
+			scatters.insert(scatters.end(),segs.begin()+e.first,segs.begin()+e.last);
 		}
-		return;
 	}
-
-	std::size_t range{count/thread_number};
-	std::size_t const module{count-range*thread_number};
-	std::size_t const allocation_size{range*chars_per_element};
-
-	std::vector<details::span_raii<char_type>> thread_result;
-	thread_result.reserve(thread_number);
-	{
-	std::vector<std::jthread> jth;
-	jth.reserve(thread_number);
-	std::size_t const offset{(range<<1)+module};
-	std::size_t const offset_allocation_size{(range+module)*chars_per_element};
-	jth.emplace_back(print_out<char_type,Func>,std::addressof(thread_result.emplace_back(new char_type[offset_allocation_size],offset_allocation_size).osp),
-		func,range,offset);
-	for(std::size_t i{2};i<thread_number;++i)
-		jth.emplace_back(print_out<char_type,Func>,std::addressof(thread_result.emplace_back(new char_type[allocation_size],allocation_size).osp),
-		func,offset+(i-2)*range,offset+(i-1)*range);
-	if constexpr(reserve_output_stream<stm>)
-		func(output,0,range);
 	else
 	{
-		span_raii<char_type> osp{new char_type[allocation_size],allocation_size};
-		func(osp.osp,0,range);
-		write(output,osp.osp.span().data(),osp.osp.span().data()+osize(osp.osp));
-	}
+		auto task{[&](std::size_t chunk,std::size_t worker)
+		{
+			std::size_t const start_number{chunk*range+(chunk<module?chunk:module)};
+			std::size_t const stop_number{start_number+range+(chunk<module)};
+			std::size_t const capacity{(stop_number-start_number)*chars_per_element};
+			auto& sc{executor.scratch(worker)};
+			std::size_t const offset{sc.prepare(capacity*sizeof(char_type),alignof(char_type))};
+			fast_io::ospan<char_type> osp{reinterpret_cast<char_type*>(sc.data()+offset),capacity};
+			func(osp,start_number,stop_number);
+			std::size_t const written{osp.size()*sizeof(char_type)};
+			sc.commit(written);
+			results[chunk]={worker,offset,offset+written};
+		}};
+		executor.run(chunks,task);
+		scatters.reserve(chunks);
+		for(auto const& e : results)
+			scatters.push_back({executor.scratch(e.worker).data()+e.first,e.last-e.first});
 	}
-	for(auto& e : thread_result)
-		write(output,e.osp.span().data(),e.osp.span().data()+osize(e.osp));
+	parallel_write_scatters(output,scatters.data(),scatters.data()+scatters.size());
 }
 
 template<output_stream stm,typename Func>
@@ -154,7 +302,9 @@ void parrallel_details(stm& output,std::size_t count,std::size_t chars_per_eleme
 #if __cpp_lib_is_constant_evaluated >= 201811L
 	if(std::is_constant_evaluated())
 	{
-		if constexpr(reserve_output_stream<stm>)
+		if(chars_per_element==0)
+			func(output,0,count);
+		else if constexpr(reserve_output_stream<stm>)
 		{
 			func(output,0,count);
 		}
@@ -163,7 +313,7 @@ void parrallel_details(stm& output,std::size_t count,std::size_t chars_per_eleme
 			std::size_t const total_chars{count*chars_per_element};
 			span_raii<char_type> osp{new char_type[total_chars],total_chars};
 			func(osp.osp,0,count);
-			write(output,osp.osp.span().data(),osp.osp.span().data()+osize(osp.osp));
+			write(output,osp.osp.span.data(),osp.osp.span.data()+osp.osp.size());
 		}
 	}
 	else
@@ -175,6 +325,16 @@ void parrallel_details(stm& output,std::size_t count,std::size_t chars_per_eleme
 #endif
 }
 
+//0 sends elements whose output has no upper bound down the segmented path
+template<typename T>
+inline constexpr std::size_t parallel_chars_per_element() noexcept
+{
+	if constexpr(reserve_printable<T>)
+		return print_reserve_size(io_reserve_type<T>);
+	else
+		return 0;
+}
+
 
 }
 
@@ -191,9 +351,9 @@ inline constexpr void print_define(stm& output,manip::parallel<R,Func> ref)
 	auto be{std::ranges::begin(ref.reference)};
 	if constexpr(std::same_as<void,Func>)
 	{
-		constexpr std::size_t sz{print_reserve_size(io_reserve_type<std::remove_cvref_t<std::ranges::range_value_t<R>>>)};
+		constexpr std::size_t sz{details::parallel_chars_per_element<std::remove_cvref_t<std::ranges::range_value_t<R>>>()};
 		details::parrallel_details(output,std::ranges::size(ref.reference),sz,
-			[be](reserve_output_stream auto& output,std::size_t start_number,std::size_t stop_number)
+			[be](output_stream auto& output,std::size_t start_number,std::size_t stop_number)
 		{
 			auto ed{be+stop_number};
 			for(auto iter{be+start_number};iter!=ed;++iter)
@@ -202,11 +362,11 @@ inline constexpr void print_define(stm& output,manip::parallel<R,Func> ref)
 	}
 	else
 	{
-		constexpr std::size_t sz{print_reserve_size(io_reserve_type<std::remove_cvref_t<
-		decltype(ref.callback(*std::ranges::begin(ref.reference)))>>)};
+		constexpr std::size_t sz{details::parallel_chars_per_element<std::remove_cvref_t<
+		decltype(ref.callback(*std::ranges::begin(ref.reference)))>>()};
 
 		details::parrallel_details(output,std::ranges::size(ref.reference),sz,
-			[&](reserve_output_stream auto& output,std::size_t start_number,std::size_t stop_number)
+			[&](output_stream auto& output,std::size_t start_number,std::size_t stop_number)
 		{
 			auto ed{be+stop_number};
 			for(auto iter{be+start_number};iter!=ed;++iter)
@@ -219,10 +379,10 @@ inline constexpr void print_define(stm& output,manip::parallel<R,Func> ref)
 template<output_stream stm,typename Func>
 inline constexpr void print_define(stm& output,manip::parallel_unit<Func> ref)
 {
-	constexpr std::size_t sz{print_reserve_size(io_reserve_type<std::remove_cvref_t<
-	decltype(ref.callback(static_cast<std::size_t>(0)))>>)};
+	constexpr std::size_t sz{details::parallel_chars_per_element<std::remove_cvref_t<
+	decltype(ref.callback(static_cast<std::size_t>(0)))>>()};
 	details::parrallel_details(output,ref.count,sz,
-		[&ref](reserve_output_stream auto& output,std::size_t start_number,std::size_t stop_number)
+		[&ref](output_stream auto& output,std::size_t start_number,std::size_t stop_number)
 	{
 		for(;start_number!=stop_number;++start_number)
 			print(output,ref.callback(start_number));
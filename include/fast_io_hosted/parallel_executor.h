@@ -0,0 +1,318 @@
+#pragma once
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<deque>
+#include<exception>
+
+namespace fast_io
+{
+
+/*
+parallel_executor is a persistent work-stealing thread pool. run(tasks,func) splits a job into tasks that are dealt
+round-robin to the per-worker deques. A worker pops from the back of its own deque and steals from the front of the
+others once it runs dry. The calling thread takes part as worker 0, so an executor of N workers owns N-1 threads.
+Every worker owns a scratch buffer and a segment pool that keep their memory between jobs. parallel, parallel_counter and parallel_unit
+run on parallel_executor::global().
+run is serialized, so jobs submitted from several threads wait their turn. A job must not call run on the same
+executor again.
+*/
+
+class parallel_scratch
+{
+	std::byte* buffer{};
+	std::size_t used{};
+	std::size_t capacity{};
+public:
+	constexpr parallel_scratch() noexcept=default;
+	parallel_scratch(parallel_scratch const&)=delete;
+	parallel_scratch& operator=(parallel_scratch const&)=delete;
+	~parallel_scratch()
+	{
+		if(buffer)
+			io_aligned_allocator<std::byte>{}.deallocate(buffer,capacity);
+	}
+	std::byte* data() noexcept
+	{
+		return buffer;
+	}
+	std::size_t size() const noexcept
+	{
+		return used;
+	}
+	void clear() noexcept
+	{
+		used={};
+	}
+//make room for bytes more and return the offset where they start. Offsets stay valid when the buffer grows.
+	std::size_t prepare(std::size_t bytes,std::size_t alignment=alignof(std::max_align_t))
+	{
+		std::size_t const offset{(used+(alignment-1))/alignment*alignment};
+		if(capacity<offset+bytes)
+		{
+			std::size_t new_capacity{capacity<<1};
+			if(new_capacity<offset+bytes)
+				new_capacity=offset+bytes;
+			auto new_buffer{io_aligned_allocator<std::byte>{}.allocate(new_capacity)};
+			if(buffer)
+			{
+				memcpy(new_buffer,buffer,used);
+				io_aligned_allocator<std::byte>{}.deallocate(buffer,capacity);
+			}
+			buffer=new_buffer;
+			capacity=new_capacity;
+		}
+		used=offset;
+		return offset;
+	}
+	void commit(std::size_t bytes) noexcept
+	{
+		used+=bytes;
+	}
+};
+
+/*
+parallel_segment_pool hands out fixed size blocks for output of unknown length and keeps them for the next job.
+segments collects the filled parts of the blocks in the order they were written.
+*/
+class parallel_segment_pool
+{
+	std::vector<std::byte*> blocks;
+	std::size_t used{};
+public:
+	static inline constexpr std::size_t block_size{65536};
+	std::vector<io_scatter_t> segments;
+	std::byte *cursor{},*cursor_end{};
+	constexpr parallel_segment_pool() noexcept=default;
+	parallel_segment_pool(parallel_segment_pool const&)=delete;
+	parallel_segment_pool& operator=(parallel_segment_pool const&)=delete;
+	~parallel_segment_pool()
+	{
+		for(auto e : blocks)
+			io_aligned_allocator<std::byte>{}.deallocate(e,block_size);
+	}
+	std::byte* next_block()
+	{
+		if(used==blocks.size())
+		{
+			blocks.reserve(blocks.size()+1);
+			blocks.push_back(io_aligned_allocator<std::byte>{}.allocate(block_size));
+		}
+		return blocks[used++];
+	}
+	void clear() noexcept
+	{
+		used={};
+		segments.clear();
+		cursor=cursor_end=nullptr;
+	}
+};
+
+class parallel_executor
+{
+	struct worker_queue
+	{
+		std::mutex mtx;
+		std::deque<std::size_t> tasks;
+	};
+	std::unique_ptr<worker_queue[]> queues;
+	std::unique_ptr<parallel_scratch[]> scratches;
+	std::unique_ptr<parallel_segment_pool[]> segment_pools;
+	std::vector<std::jthread> threads;
+	std::size_t workers{};
+	std::atomic<std::size_t> limit{};
+	std::atomic<std::size_t> active{};
+	std::mutex session_mtx;
+	std::mutex run_mtx;
+	std::mutex mtx;
+	std::condition_variable job_cv,done_cv;
+	std::size_t generation{};
+	bool stopping{};
+	void (*job_function)(void*,std::size_t,std::size_t){};
+	void* job_context{};
+	std::atomic<std::size_t> remaining{};
+#ifdef __cpp_exceptions
+	std::exception_ptr error;
+#endif
+
+	bool pop_or_steal(std::size_t index,std::size_t& task) noexcept
+	{
+		{
+			auto& q{queues[index]};
+			std::lock_guard lg{q.mtx};
+			if(!q.tasks.empty())
+			{
+				task=q.tasks.back();
+				q.tasks.pop_back();
+				return true;
+			}
+		}
+		std::size_t const n{active.load(std::memory_order_relaxed)};
+		for(std::size_t i{1};i<n;++i)
+		{
+			std::size_t victim{(index+i)%n};
+			auto& q{queues[victim]};
+			std::lock_guard lg{q.mtx};
+			if(!q.tasks.empty())
+			{
+//a worker still leaving the previous job must not take part in a job whose limit excludes it
+				if(active.load(std::memory_order_relaxed)<=index)
+					return false;
+				task=q.tasks.front();
+				q.tasks.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+	void execute(std::size_t index) noexcept
+	{
+		for(std::size_t task;pop_or_steal(index,task);)
+		{
+#ifdef __cpp_exceptions
+			try
+			{
+#endif
+				job_function(job_context,task,index);
+#ifdef __cpp_exceptions
+			}
+			catch(...)
+			{
+				std::lock_guard lg{mtx};
+				if(!error)
+					error=std::current_exception();
+			}
+#endif
+			if(remaining.fetch_sub(1,std::memory_order_acq_rel)==1)
+			{
+				std::lock_guard lg{mtx};
+				done_cv.notify_all();
+			}
+		}
+	}
+	void worker_loop(std::size_t index) noexcept
+	{
+		for(std::size_t seen{};;)
+		{
+			{
+				std::unique_lock lk{mtx};
+				job_cv.wait(lk,[&]{return stopping||generation!=seen;});
+				if(stopping)
+					return;
+				seen=generation;
+				if(active.load(std::memory_order_relaxed)<=index)
+					continue;
+			}
+			execute(index);
+		}
+	}
+public:
+//0 means std::thread::hardware_concurrency()
+	explicit parallel_executor(std::size_t worker_count=0)
+	{
+		if(worker_count==0)
+			worker_count=std::thread::hardware_concurrency();
+		if(worker_count==0)
+			worker_count=1;
+		workers=worker_count;
+		limit.store(worker_count,std::memory_order_relaxed);
+		queues=std::make_unique<worker_queue[]>(workers);
+		scratches=std::make_unique<parallel_scratch[]>(workers);
+		segment_pools=std::make_unique<parallel_segment_pool[]>(workers);
+		threads.reserve(workers-1);
+		for(std::size_t i{1};i!=workers;++i)
+			threads.emplace_back([this,i]{worker_loop(i);});
+	}
+	parallel_executor(parallel_executor const&)=delete;
+	parallel_executor& operator=(parallel_executor const&)=delete;
+	~parallel_executor()
+	{
+		{
+			std::lock_guard lg{mtx};
+			stopping=true;
+		}
+		job_cv.notify_all();
+		threads.clear();
+	}
+	static parallel_executor& global()
+	{
+		static parallel_executor executor;
+		return executor;
+	}
+//workers that take part in the next jobs, including the calling thread
+	std::size_t concurrency() const noexcept
+	{
+		return limit.load(std::memory_order_relaxed);
+	}
+//cap the workers used from the next job on. 0 lifts the cap.
+	void set_concurrency_limit(std::size_t n) noexcept
+	{
+		if(n==0||workers<n)
+			n=workers;
+		limit.store(n,std::memory_order_relaxed);
+	}
+//held by the caller for as long as it uses the scratch buffers of a job. It may span several runs.
+	std::mutex& session() noexcept
+	{
+		return session_mtx;
+	}
+	parallel_scratch& scratch(std::size_t index) noexcept
+	{
+		return scratches[index];
+	}
+	parallel_segment_pool& segment_pool(std::size_t index) noexcept
+	{
+		return segment_pools[index];
+	}
+	void clear_scratches() noexcept
+	{
+		for(std::size_t i{};i!=workers;++i)
+		{
+			scratches[i].clear();
+			segment_pools[i].clear();
+		}
+	}
+//func(task,worker) for every task in [0,tasks). Returns when all tasks are done.
+	template<typename Func>
+	void run(std::size_t tasks,Func& func)
+	{
+		if(tasks==0)
+			return;
+		std::lock_guard run_lg{run_mtx};
+		{
+			std::lock_guard lg{mtx};
+			std::size_t n{limit.load(std::memory_order_relaxed)};
+			if(tasks<n)
+				n=tasks;
+			active.store(n,std::memory_order_relaxed);
+			job_function=[](void* ctx,std::size_t task,std::size_t worker)
+			{
+				(*static_cast<Func*>(ctx))(task,worker);
+			};
+			job_context=std::addressof(func);
+			remaining.store(tasks,std::memory_order_relaxed);
+			for(std::size_t i{};i!=tasks;++i)
+			{
+				auto& q{queues[i%n]};
+				std::lock_guard qlg{q.mtx};
+				q.tasks.push_back(i);
+			}
+			++generation;
+		}
+		if(1<active.load(std::memory_order_relaxed))
+			job_cv.notify_all();
+		execute(0);
+		std::unique_lock lk{mtx};
+		done_cv.wait(lk,[this]{return remaining.load(std::memory_order_acquire)==0;});
+#ifdef __cpp_exceptions
+		if(error)
+		{
+			auto eptr{std::move(error)};
+			error=nullptr;
+			std::rethrow_exception(eptr);
+		}
+#endif
+	}
+};
+
+}
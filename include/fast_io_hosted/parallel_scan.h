@@ -0,0 +1,151 @@
+#pragma once
+
+namespace fast_io
+{
+
+/*
+parallel_scan_chunks<T>(in) scans every T of a text input with all the workers of parallel_executor::global().
+The input is cut at whitespace into chunks that are parsed independently with the ordinary scan of T, each into its
+own vector. The vectors come back in input order. Contiguous inputs such as imap_file are cut in place. Other buffer
+input streams are read in blocks, and the unfinished token at the end of a block is carried into the next one.
+parallel_scan<T>(in) joins the chunks into one vector.
+Every token must be whitespace separated and parse as a whole. A token that does not, such as abc or 12abc for an
+integer, throws fast_io_text_error instead of cutting the result short.
+*/
+
+struct parallel_scan_options
+{
+	std::size_t min_chunk_size{1048576};	//inputs are never cut into chunks smaller than this
+	std::size_t block_size{67108864};	//bytes read at once from inputs that are not contiguous
+};
+
+namespace details
+{
+
+//move p forward onto the next whitespace so that no token straddles two chunks
+template<std::integral char_type>
+inline constexpr char_type const* parallel_scan_boundary(char_type const* p,char_type const* last) noexcept
+{
+	for(;p!=last&&!is_space(*p);++p);
+	return p;
+}
+
+template<typename T,std::integral char_type>
+inline void parallel_scan_range(std::vector<std::vector<T>>& results,char_type const* first,char_type const* last,
+	parallel_scan_options const& options)
+{
+	if(first==last)
+		return;
+	auto& executor{parallel_executor::global()};
+	std::lock_guard lg{executor.session()};
+	std::size_t const workers{executor.concurrency()};
+	std::size_t const bytes{static_cast<std::size_t>(last-first)*sizeof(char_type)};
+	std::size_t const min_chunk_size{options.min_chunk_size?options.min_chunk_size:1};
+	std::size_t chunks{workers<2?1:(workers<<2)};
+	if(bytes/min_chunk_size<chunks)
+		chunks=bytes/min_chunk_size;
+	if(chunks==0)
+		chunks=1;
+	std::vector<char_type const*> boundaries(chunks+1);
+	boundaries.front()=first;
+	boundaries.back()=last;
+	std::size_t const chars(last-first);
+	for(std::size_t i{1};i!=chunks;++i)
+	{
+		char_type const* p{first+chars/chunks*i};
+		if(p<boundaries[i-1])
+			p=boundaries[i-1];
+		boundaries[i]=parallel_scan_boundary(p,last);
+	}
+	std::size_t const base{results.size()};
+	results.resize(base+chunks);
+	auto task{[&](std::size_t chunk,std::size_t)
+	{
+		istring_view<char_type> view(boundaries[chunk],static_cast<std::size_t>(boundaries[chunk+1]-boundaries[chunk]));
+		auto& out{results[base+chunk]};
+		for(T t;scan<true>(view,t);)
+		{
+			if(auto curr{ibuffer_curr(view)};curr!=ibuffer_end(view)&&!is_space(*curr))[[unlikely]]
+#ifdef __cpp_exceptions
+				throw fast_io_text_error("malformed input");
+#else
+				fast_terminate();
+#endif
+			out.push_back(t);
+		}
+	}};
+	executor.run(chunks,task);
+}
+
+template<typename T,buffer_input_stream input>
+inline void parallel_scan_blocks(std::vector<std::vector<T>>& results,input& in,parallel_scan_options const& options)
+{
+	using char_type = typename input::char_type;
+	std::size_t capacity{options.block_size/sizeof(char_type)};
+	if(capacity==0)
+		capacity=1;
+	std::vector<char_type> buffer(capacity);
+	std::size_t carried{};
+	for(;;)
+	{
+		auto first{buffer.data()};
+		auto filled{read_all(in,first+carried,first+buffer.size())};
+		bool const eof{filled!=first+buffer.size()};
+		char_type const* cut{filled};
+		if(!eof)
+		{
+			for(;cut!=first&&!is_space(cut[-1]);--cut);
+			if(cut==first)
+			{
+//one token fills the whole block
+				carried=buffer.size();
+				buffer.resize(buffer.size()<<1);
+				continue;
+			}
+		}
+		parallel_scan_range(results,static_cast<char_type const*>(first),cut,options);
+		if(eof)
+			return;
+		carried=static_cast<std::size_t>(filled-cut);
+		std::copy(cut,static_cast<char_type const*>(filled),first);
+	}
+}
+
+}
+
+template<typename T,buffer_input_stream input>
+inline std::vector<std::vector<T>> parallel_scan_chunks(input& in,parallel_scan_options const& options={})
+{
+	std::vector<std::vector<T>> results;
+	if constexpr(contiguous_buffer_input_stream<input>)
+	{
+		auto last{ibuffer_end(in)};
+		details::parallel_scan_range(results,ibuffer_curr(in),last,options);
+		ibuffer_set_curr(in,last);
+	}
+	else
+		details::parallel_scan_blocks(results,in,options);
+	return results;
+}
+
+template<typename T,buffer_input_stream input>
+inline std::vector<T> parallel_scan(input& in,parallel_scan_options const& options={})
+{
+	auto chunks{parallel_scan_chunks<T>(in,options)};
+	if(chunks.size()==1)
+		return std::move(chunks.front());
+	std::vector<std::size_t> offsets(chunks.size()+1);
+	for(std::size_t i{};i!=chunks.size();++i)
+		offsets[i+1]=offsets[i]+chunks[i].size();
+	std::vector<T> values(offsets.back());
+	auto& executor{parallel_executor::global()};
+	std::lock_guard lg{executor.session()};
+	auto task{[&](std::size_t chunk,std::size_t)
+	{
+		std::copy(chunks[chunk].cbegin(),chunks[chunk].cend(),values.begin()+offsets[chunk]);
+	}};
+	executor.run(chunks.size(),task);
+	return values;
+}
+
+}
@@ -0,0 +1,209 @@
+#pragma once
+#include<thread>
+#include<mutex>
+#include<exception>
+
+namespace fast_io
+{
+
+/*
+parallel_random_access_transmit copies a byte range of a file with several threads. The range is split into chunks
+and every worker claims the next chunk from a shared counter, so a slow chunk never stalls the others. A chunk is
+moved with copy_file_range when both ends are regular files, otherwise with pread/pwrite through an aligned per worker
+buffer. Neither file position is used by the workers. Afterwards the output position moves past the bytes written,
+as with random_access_transmit.
+*/
+
+struct parallel_transmit_options
+{
+	std::size_t threads{};				//0 means std::thread::hardware_concurrency()
+	std::size_t chunk_size{16777216};
+	std::size_t buffer_size{1048576};	//pread/pwrite bounce buffer of every worker
+};
+
+struct parallel_transmit_progress
+{
+	std::uintmax_t transmitted{};
+	std::uintmax_t total{};
+};
+
+namespace details
+{
+
+struct no_parallel_transmit_progress
+{
+	inline constexpr void operator()(parallel_transmit_progress) const noexcept{}
+};
+
+inline std::size_t parallel_transmit_pread_pwrite(int out_fd,std::uintmax_t out_offset,int in_fd,std::uintmax_t in_offset,
+	std::size_t bytes,std::byte* buffer,std::size_t buffer_size)
+{
+	std::size_t transmitted{};
+	for(;transmitted!=bytes;)
+	{
+		std::size_t to_read{bytes-transmitted};
+		if(buffer_size<to_read)
+			to_read=buffer_size;
+		auto const r{::pread(in_fd,buffer,to_read,static_cast<off_t>(in_offset+transmitted))};
+		if(r==-1)
+			throw_posix_error();
+		if(r==0)
+			break;
+		std::size_t const got{static_cast<std::size_t>(r)};
+		for(std::size_t written{};written!=got;)
+		{
+			auto const w{::pwrite(out_fd,buffer+written,got-written,static_cast<off_t>(out_offset+transmitted+written))};
+			if(w==-1)
+				throw_posix_error();
+			written+=static_cast<std::size_t>(w);
+		}
+		transmitted+=got;
+	}
+	return transmitted;
+}
+
+#ifdef __linux__
+//returns SIZE_MAX when the filesystem refuses copy_file_range and nothing was copied
+inline std::size_t parallel_transmit_copy_file_range(int out_fd,std::uintmax_t out_offset,int in_fd,std::uintmax_t in_offset,std::size_t bytes)
+{
+	loff_t in_off(static_cast<loff_t>(in_offset)),out_off(static_cast<loff_t>(out_offset));
+	std::size_t transmitted{};
+	for(;transmitted!=bytes;)
+	{
+		auto const r{::copy_file_range(in_fd,std::addressof(in_off),out_fd,std::addressof(out_off),bytes-transmitted,0)};
+		if(r==-1)
+		{
+			if(transmitted==0&&(errno==EXDEV||errno==EINVAL||errno==EOPNOTSUPP||errno==ENOSYS))
+				return SIZE_MAX;
+			throw_posix_error();
+		}
+		if(r==0)
+			break;
+		transmitted+=static_cast<std::size_t>(r);
+	}
+	return transmitted;
+}
+#endif
+
+template<typename Func>
+inline std::uintmax_t parallel_random_access_transmit_impl(int out_fd,std::uintmax_t out_offset,int in_fd,std::uintmax_t in_offset,
+	std::uintmax_t bytes,parallel_transmit_options const& options,Func& progress)
+{
+	if(bytes==0)
+		return 0;
+	std::size_t const chunk_size{options.chunk_size?options.chunk_size:16777216};
+	std::uintmax_t const chunks{(bytes+(chunk_size-1))/chunk_size};
+	std::size_t threads{options.threads?options.threads:std::thread::hardware_concurrency()};
+	if(threads==0)
+		threads=1;
+	if(chunks<threads)
+		threads=static_cast<std::size_t>(chunks);
+	std::size_t const buffer_size{options.buffer_size?options.buffer_size:1048576};
+#ifdef __linux__
+	bool use_copy_file_range{};
+	{
+		struct stat in_st,out_st;
+		use_copy_file_range=::fstat(in_fd,std::addressof(in_st))!=-1&&::fstat(out_fd,std::addressof(out_st))!=-1&&
+			S_ISREG(in_st.st_mode)&&S_ISREG(out_st.st_mode);
+	}
+	std::atomic<bool> copy_file_range_refused{};
+#endif
+	std::atomic<std::uintmax_t> next_chunk{};
+	std::atomic<bool> stopping{};
+	std::mutex mtx;
+	std::uintmax_t transmitted{};
+#ifdef __cpp_exceptions
+	std::exception_ptr error;
+#endif
+	auto worker{[&]() noexcept
+	{
+		std::byte* buffer{};
+#ifdef __cpp_exceptions
+		try
+		{
+#endif
+			for(std::uintmax_t chunk;!stopping.load(std::memory_order_relaxed)&&(chunk=next_chunk.fetch_add(1,std::memory_order_relaxed))<chunks;)
+			{
+				std::uintmax_t const position{chunk*chunk_size};
+				std::size_t this_chunk{chunk_size};
+				if(bytes-position<this_chunk)
+					this_chunk=static_cast<std::size_t>(bytes-position);
+				std::size_t done{SIZE_MAX};
+#ifdef __linux__
+				if(use_copy_file_range&&!copy_file_range_refused.load(std::memory_order_relaxed))
+				{
+					done=parallel_transmit_copy_file_range(out_fd,out_offset+position,in_fd,in_offset+position,this_chunk);
+					if(done==SIZE_MAX)
+						copy_file_range_refused.store(true,std::memory_order_relaxed);
+				}
+#endif
+				if(done==SIZE_MAX)
+				{
+					if(buffer==nullptr)
+						buffer=io_aligned_allocator<std::byte>{}.allocate(buffer_size);
+					done=parallel_transmit_pread_pwrite(out_fd,out_offset+position,in_fd,in_offset+position,this_chunk,buffer,buffer_size);
+				}
+				std::lock_guard lg{mtx};
+				transmitted+=done;
+				progress(parallel_transmit_progress{transmitted,bytes});
+			}
+#ifdef __cpp_exceptions
+		}
+		catch(...)
+		{
+			stopping.store(true,std::memory_order_relaxed);
+			std::lock_guard lg{mtx};
+			if(!error)
+				error=std::current_exception();
+		}
+#endif
+		if(buffer)
+			io_aligned_allocator<std::byte>{}.deallocate(buffer,buffer_size);
+	}};
+	{
+		std::vector<std::jthread> jth;
+		jth.reserve(threads-1);
+		for(std::size_t i{1};i<threads;++i)
+			jth.emplace_back(worker);
+		worker();
+	}
+#ifdef __cpp_exceptions
+	if(error)
+		std::rethrow_exception(error);
+#endif
+	return transmitted;
+}
+
+}
+
+template<zero_copy_output_stream output,std::integral offset_type,zero_copy_input_stream input,std::integral sz_type,
+	typename Func=details::no_parallel_transmit_progress>
+requires (random_access_stream<output>&&std::invocable<Func&,parallel_transmit_progress>)
+inline std::uintmax_t parallel_random_access_transmit(output&& outp,offset_type offset,input&& in,sz_type bytes,
+	Func progress={},parallel_transmit_options const& options={})
+{
+	if constexpr(buffer_output_stream<std::remove_cvref_t<output>>)
+		flush(outp);
+	std::uintmax_t const out_offset{static_cast<std::uintmax_t>(seek(outp,0,seekdir::cur))};
+	std::uintmax_t const transmitted{details::parallel_random_access_transmit_impl(zero_copy_out_handle(outp),out_offset,
+		zero_copy_in_handle(in),static_cast<std::uintmax_t>(offset),static_cast<std::uintmax_t>(bytes),options,progress)};
+	seek(outp,static_cast<std::intmax_t>(transmitted),seekdir::cur);
+	return transmitted;
+}
+
+//transmit everything from offset to the current end of the input file
+template<zero_copy_output_stream output,std::integral offset_type,zero_copy_input_stream input,
+	typename Func=details::no_parallel_transmit_progress>
+requires (random_access_stream<output>&&std::invocable<Func&,parallel_transmit_progress>)
+inline std::uintmax_t parallel_random_access_transmit(output&& outp,offset_type offset,input&& in,
+	Func progress={},parallel_transmit_options const& options={})
+{
+	struct stat st;
+	if(::fstat(zero_copy_in_handle(in),std::addressof(st))==-1)
+		throw_posix_error();
+	std::uintmax_t const size{static_cast<std::uintmax_t>(st.st_size)};
+	std::uintmax_t const start{static_cast<std::uintmax_t>(offset)};
+	return parallel_random_access_transmit(outp,offset,in,start<size?size-start:0,std::move(progress),options);
+}
+
+}
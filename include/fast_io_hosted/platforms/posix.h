@@ -4,6 +4,7 @@
 #include<io.h>
 #else
 #include<unistd.h>
+#include<sys/stat.h>
 #endif
 #include<fcntl.h>
 #ifdef __linux__
@@ -96,6 +97,8 @@ inline constexpr int calculate_posix_open_mode(open_mode value)
 	if((value&open_mode::binary)!=open_mode::none)
 		mode |= O_BINARY;
 #endif
+	if((value&open_mode::creat)!=open_mode::none)
+		mode |= O_CREAT;
 	if((value&open_mode::excl)!=open_mode::none)
 		mode |= O_CREAT | O_EXCL;
 	if((value&open_mode::trunc)!=open_mode::none)
@@ -474,6 +477,70 @@ inline void io_control(basic_posix_io_observer<ch_type> h,Args&& ...args)
 }
 #endif
 
+#if !defined(__WINNT__) && !defined(_MSC_VER)
+/*
+Preferred buffer size in bytes for the device behind h. 0 means unknown and the buffer keeps its default.
+Pipes and fifos use the kernel pipe capacity. Character devices such as ttys use st_blksize.
+Regular files and block devices use the default buffer size rounded up to a multiple of st_blksize.
+*/
+template<std::integral ch_type>
+inline std::size_t io_buffer_size_hint(basic_posix_io_observer<ch_type> h) noexcept
+{
+	struct stat st;
+	if(::fstat(h.native_handle(),std::addressof(st))==-1)
+		return 0;
+	std::size_t const blksize(st.st_blksize<=0?0:static_cast<std::size_t>(st.st_blksize));
+	if(S_ISFIFO(st.st_mode))
+	{
+#if defined(__linux__) && defined(F_GETPIPE_SZ)
+		int pipe_size(::fcntl(h.native_handle(),F_GETPIPE_SZ));
+		if(0<pipe_size)
+			return static_cast<std::size_t>(pipe_size);
+#endif
+		return blksize;
+	}
+	if(S_ISCHR(st.st_mode))
+		return blksize;
+	if(S_ISREG(st.st_mode)||S_ISBLK(st.st_mode))
+	{
+		constexpr std::size_t default_size{details::cal_buffer_size<char,true>()};
+		if(blksize==0||default_size%blksize==0)
+			return default_size;
+		return (default_size/blksize+1)*blksize;
+	}
+	return 0;
+}
+
+#ifdef __linux__
+/*
+Offset and size alignment in bytes required by O_DIRECT on h. 0 means unknown.
+Uses statx(STATX_DIOALIGN) when the kernel reports it and BLKSSZGET for block devices.
+*/
+template<std::integral ch_type>
+inline std::size_t io_direct_alignment(basic_posix_io_observer<ch_type> h) noexcept
+{
+#ifdef STATX_DIOALIGN
+	struct statx stx;
+	if(::statx(h.native_handle(),"",AT_EMPTY_PATH,STATX_DIOALIGN|STATX_TYPE,std::addressof(stx))==0&&
+		(stx.stx_mask&STATX_DIOALIGN)&&stx.stx_dio_offset_align)
+		return stx.stx_dio_offset_align;
+#endif
+	struct stat st;
+	if(::fstat(h.native_handle(),std::addressof(st))==-1)
+		return 0;
+	if(S_ISBLK(st.st_mode))
+	{
+//BLKSSZGET from <linux/fs.h>. The header is not included since it conflicts with <sys/mount.h>
+		constexpr unsigned long blksszget{0x1268};
+		int logical_block_size{};
+		if(ioctl(h.native_handle(),blksszget,std::addressof(logical_block_size))==0&&0<logical_block_size)
+			return static_cast<std::size_t>(logical_block_size);
+	}
+	return 0;
+}
+#endif
+#endif
+
 template<std::integral ch_type>
 class basic_posix_file:public basic_posix_io_handle<ch_type>
 {
@@ -764,15 +831,71 @@ inline int constexpr posix_stderr_number = 2;
 namespace details
 {
 
+#ifdef __linux__
+/*
+sendfile only covers file to socket/file. copy_file_range lets the filesystem reflink or copy server side, and splice
+moves pages in and out of pipes. The method is picked once per transmit from the kinds of both descriptors.
+*/
+enum class zero_copy_transmit_method
+{
+sendfile,copy_file_range,splice_from_pipe,splice_to_pipe
+};
+
+inline zero_copy_transmit_method zero_copy_transmit_method_of(int out_fd,int in_fd) noexcept
+{
+	struct stat in_st,out_st;
+	if(::fstat(in_fd,std::addressof(in_st))==-1||::fstat(out_fd,std::addressof(out_st))==-1)
+		return zero_copy_transmit_method::sendfile;
+	if(S_ISFIFO(in_st.st_mode))
+		return zero_copy_transmit_method::splice_from_pipe;
+	if(S_ISFIFO(out_st.st_mode))
+		return zero_copy_transmit_method::splice_to_pipe;
+	if(S_ISREG(in_st.st_mode)&&S_ISREG(out_st.st_mode))
+		return zero_copy_transmit_method::copy_file_range;
+	return zero_copy_transmit_method::sendfile;
+}
+
+//sendfile stops short only at end of file. copy_file_range and splice may stop short at any time and end with 0.
+inline constexpr bool zero_copy_transmit_continues(zero_copy_transmit_method method,std::size_t transferred) noexcept
+{
+	return method!=zero_copy_transmit_method::sendfile&&transferred!=0;
+}
+#endif
+
 template<bool random_access=false,bool report_einval=false,zero_copy_output_stream output,zero_copy_input_stream input>
 inline std::conditional_t<report_einval,std::pair<std::size_t,bool>,std::size_t>
-	zero_copy_transmit_once(output& outp,input& inp,std::size_t bytes,std::intmax_t offset)
+	zero_copy_transmit_once(output& outp,input& inp,std::size_t bytes,std::intmax_t offset
+#ifdef __linux__
+	,zero_copy_transmit_method& method
+#endif
+	)
 {
 #ifdef __linux__
 	std::intmax_t *np{};
 	if constexpr(random_access)
 		np=std::addressof(offset);
-	auto transmitted_bytes(::sendfile(zero_copy_out_handle(outp),zero_copy_in_handle(inp),np,bytes));
+	std::ptrdiff_t transmitted_bytes{};
+	switch(method)
+	{
+	case zero_copy_transmit_method::copy_file_range:
+		transmitted_bytes=::copy_file_range(zero_copy_in_handle(inp),np,zero_copy_out_handle(outp),nullptr,bytes,0);
+		if(transmitted_bytes!=-1)
+			break;
+//EXDEV, EOPNOTSUPP or ENOSYS on older kernels and some filesystems. sendfile still avoids the user space copy.
+//Any other error is a real one and is reported below.
+		if(errno!=EXDEV&&errno!=EOPNOTSUPP&&errno!=ENOSYS)
+			break;
+		method=zero_copy_transmit_method::sendfile;
+		[[fallthrough]];
+	case zero_copy_transmit_method::sendfile:
+		transmitted_bytes=::sendfile(zero_copy_out_handle(outp),zero_copy_in_handle(inp),np,bytes);
+		break;
+	case zero_copy_transmit_method::splice_from_pipe:
+		transmitted_bytes=::splice(zero_copy_in_handle(inp),nullptr,zero_copy_out_handle(outp),nullptr,bytes,SPLICE_F_MOVE);
+		break;
+	default:
+		transmitted_bytes=::splice(zero_copy_in_handle(inp),np,zero_copy_out_handle(outp),nullptr,bytes,SPLICE_F_MOVE);
+	}
 #else
 	off_t np{};
 	if constexpr(random_access)
@@ -801,6 +924,7 @@ inline std::conditional_t<report_einval,std::pair<std::size_t,bool>,std::size_t>
 		return transmitted_bytes;
 }
 
+}
 
 template<bool random_access=false,bool report_einval=false,zero_copy_output_stream output,zero_copy_input_stream input>
 inline std::conditional_t<report_einval,std::pair<std::uintmax_t,bool>,std::uintmax_t> zero_copy_transmit
@@ -808,13 +932,20 @@ inline std::conditional_t<report_einval,std::pair<std::uintmax_t,bool>,std::uint
 {
 	constexpr std::size_t maximum_transmit_bytes(2147479552);
 	std::uintmax_t transmitted{};
+#ifdef __linux__
+	auto method{details::zero_copy_transmit_method_of(zero_copy_out_handle(outp),zero_copy_in_handle(inp))};
+#endif
 	for(;bytes;)
 	{
 		std::size_t should_transfer(maximum_transmit_bytes);
 		if(bytes<should_transfer)
 			should_transfer=bytes;
 		std::size_t transferred_this_round{};
-		auto ret(details::zero_copy_transmit_once<random_access,report_einval>(outp,inp,should_transfer,offset));
+		auto ret(details::zero_copy_transmit_once<random_access,report_einval>(outp,inp,should_transfer,offset
+#ifdef __linux__
+		,method
+#endif
+		));
 		if constexpr(report_einval)
 		{
 			if(ret.second)
@@ -824,7 +955,13 @@ inline std::conditional_t<report_einval,std::pair<std::uintmax_t,bool>,std::uint
 		else
 			transferred_this_round=ret;
 		transmitted+=transferred_this_round;
-		if(transferred_this_round!=should_transfer)
+		if constexpr(random_access)
+			offset+=transferred_this_round;
+		if(transferred_this_round!=should_transfer
+#ifdef __linux__
+		&&!details::zero_copy_transmit_continues(method,transferred_this_round)
+#endif
+		)
 		{
 			if constexpr(report_einval)
 				return {transmitted,false};
@@ -842,10 +979,17 @@ template<bool random_access=false,bool report_einval=false,zero_copy_output_stre
 inline std::conditional_t<report_einval,std::pair<std::uintmax_t,bool>,std::uintmax_t> zero_copy_transmit(output& outp,input& inp,std::intmax_t offset)
 {
 	constexpr std::size_t maximum_transmit_bytes(2147479552);
+#ifdef __linux__
+	auto method{details::zero_copy_transmit_method_of(zero_copy_out_handle(outp),zero_copy_in_handle(inp))};
+#endif
 	for(std::uintmax_t transmitted{};;)
 	{
 		std::size_t transferred_this_round{};
-		auto ret(details::zero_copy_transmit_once<random_access,report_einval>(outp,inp,maximum_transmit_bytes,offset));
+		auto ret(details::zero_copy_transmit_once<random_access,report_einval>(outp,inp,maximum_transmit_bytes,offset
+#ifdef __linux__
+		,method
+#endif
+		));
 		if constexpr(report_einval)
 		{
 			if(ret.second)
@@ -855,7 +999,13 @@ inline std::conditional_t<report_einval,std::pair<std::uintmax_t,bool>,std::uint
 		else
 			transferred_this_round=ret;
 		transmitted+=transferred_this_round;
-		if(transferred_this_round!=maximum_transmit_bytes)
+		if constexpr(random_access)
+			offset+=transferred_this_round;
+		if(transferred_this_round!=maximum_transmit_bytes
+#ifdef __linux__
+		&&!details::zero_copy_transmit_continues(method,transferred_this_round)
+#endif
+		)
 		{
 			if constexpr(report_einval)
 				return {transmitted,false};
@@ -864,7 +1014,6 @@ inline std::conditional_t<report_einval,std::pair<std::uintmax_t,bool>,std::uint
 		}
 	}
 }
-}
 
 #endif
 template<std::integral char_type=char>
@@ -101,6 +101,44 @@ public:
 #endif
         rg = {ret, bytes};
 	}
+/*
+grow or shrink a mapping of the start of the file. The file is resized with ftruncate, so growth leaves a sparse
+tail instead of allocating disk. Linux moves the pages with mremap, elsewhere the file is mapped again.
+*/
+	template<std::integral ch_type>
+	void resize(basic_posix_io_observer<ch_type> bf,file_map_attribute attr,std::size_t bytes)
+	{
+		if(::ftruncate(bf.native_handle(),static_cast<off_t>(bytes))==-1)
+#ifdef __cpp_exceptions
+			throw posix_error();
+#else
+			fast_terminate();
+#endif
+#if defined(__linux__)
+		if(rg.data())
+		{
+			auto ret(::mremap(rg.data(),rg.size(),bytes,MREMAP_MAYMOVE));
+			if(ret==MAP_FAILED)
+#ifdef __cpp_exceptions
+				throw posix_error();
+#else
+				fast_terminate();
+#endif
+			rg={static_cast<std::byte*>(ret),bytes};
+			return;
+		}
+#endif
+		close_impl();
+		rg={};
+		auto ret(static_cast<std::byte*>(mmap(nullptr,bytes,static_cast<int>(to_posix_file_map_attribute(attr)),MAP_SHARED,bf.native_handle(),0)));
+		if(ret==MAP_FAILED)
+#ifdef __cpp_exceptions
+			throw posix_error();
+#else
+			fast_terminate();
+#endif
+		rg={ret,bytes};
+	}
 	//auto native_handle() const {return wfm.native_handle();}
 	auto& region()
 	{
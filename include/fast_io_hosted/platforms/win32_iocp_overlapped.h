@@ -67,6 +67,9 @@ class iocp_overlapped:public iocp_overlapped_observer
 {
 public:
 	using native_handle_type = iocp_overlapped_base*;
+	using observer_type = iocp_overlapped_observer;
+	template<typename T>
+	using derived_type = iocp_overlapped_derived<T>;
 	constexpr iocp_overlapped()=default;
 	constexpr iocp_overlapped(native_handle_type hd):iocp_overlapped_observer{hd}{}
 
@@ -0,0 +1,497 @@
+#pragma once
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <exception>
+
+namespace fast_io
+{
+
+/*
+basic_ring_log is an asynchronous logging stream. Every print, println or write becomes one record in a lock-free
+multi-producer single-consumer ring of fixed size slots, and a background thread drains the ring into the sink.
+A record takes as many consecutive slots as it needs, so records never interleave. When every argument is
+reserve_printable, print_reserve_size bounds the record and print_reserve_define formats it straight into the ring.
+Other records are formatted into a thread local buffer first and copied in.
+Producers only claim slots with a compare and swap and never make a system call, unless the ring is full. The policy
+then decides: block yields until there is room, drop discards the record and counts it in dropped(), and grow chains a
+ring twice as large. The consumer sleeps a little while the ring is empty and flushes the sink when it runs dry.
+Under block, a record larger than the whole ring goes in as ring sized pieces. Its producer locks the ring for other
+producers until the last piece is claimed, so the pieces still reach the sink back to back.
+Under grow, the consumer frees a retired ring once no producer is between claim and publish. Producers count
+themselves in and out for that, so grow costs one more shared atomic per record than the other policies.
+flush waits until every record published before it has reached the sink and been flushed.
+An error of the sink is kept and rethrown by the next flush or close. close drains the ring and stops the consumer, so
+no record may follow it. Like basic_obuf, the destructor has to drop an error nobody collected.
+*/
+
+enum class ring_log_overflow
+{
+	block,
+	drop,
+	grow
+};
+
+namespace details
+{
+
+template<std::integral ch_type>
+inline iomutex_batch_buffer<ch_type>& ring_log_staging() noexcept
+{
+	thread_local iomutex_batch_buffer<ch_type> buffer;
+	return buffer;
+}
+
+template<std::integral char_type,std::size_t slot_size>
+struct ring_log_segment
+{
+	static inline constexpr std::size_t closed{static_cast<std::size_t>(1)<<(std::numeric_limits<std::size_t>::digits-1)};
+//set while one producer writes a record larger than the ring. Other producers find the ring full meanwhile.
+	static inline constexpr std::size_t exclusive{closed>>1};
+	static inline constexpr std::size_t flags{closed|exclusive};
+	struct record_header
+	{
+		std::size_t length;
+		std::size_t slots;
+	};
+	std::size_t const slots;
+	std::unique_ptr<std::atomic<std::size_t>[]> sequences;
+	std::unique_ptr<record_header[]> headers;
+//twice the ring, so a record starting near the end runs on into the second half instead of wrapping
+	char_type* data{};
+	std::unique_ptr<ring_log_segment> next;
+	alignas(64) std::atomic<std::size_t> tail{};
+	alignas(64) std::atomic<std::size_t> consumed{};
+	std::atomic<bool> finished{};
+	explicit ring_log_segment(std::size_t n):slots(n),sequences(std::make_unique<std::atomic<std::size_t>[]>(n)),
+		headers(std::make_unique<record_header[]>(n)),data(io_aligned_allocator<char_type>{}.allocate((n*slot_size)<<1))
+	{
+		for(std::size_t i{};i!=n;++i)
+			sequences[i].store(i,std::memory_order_relaxed);
+	}
+	ring_log_segment(ring_log_segment const&)=delete;
+	ring_log_segment& operator=(ring_log_segment const&)=delete;
+	~ring_log_segment()
+	{
+		io_aligned_allocator<char_type>{}.deallocate(data,(slots*slot_size)<<1);
+	}
+	char_type* slot_data(std::size_t pos) const noexcept
+	{
+		return data+(pos&(slots-1))*slot_size;
+	}
+//claim k consecutive slots. Returns closed when the segment was retired and SIZE_MAX-1 when it is full.
+	template<bool exclusive_owner=false>
+	std::size_t try_claim(std::size_t k) noexcept
+	{
+		for(std::size_t pos{tail.load(std::memory_order_relaxed)};;)
+		{
+			if(pos&closed)
+				return closed;
+			if constexpr(!exclusive_owner)
+			{
+				if(pos&exclusive)
+					return SIZE_MAX-1;
+			}
+			std::size_t const start{pos&~exclusive};
+			std::size_t const last{start+k-1};
+			std::size_t const seq{sequences[last&(slots-1)].load(std::memory_order_acquire)};
+			std::ptrdiff_t const diff{static_cast<std::ptrdiff_t>(seq-last)};
+			if(diff==0)
+			{
+				if(tail.compare_exchange_weak(pos,pos+k,std::memory_order_relaxed,std::memory_order_relaxed))
+					return start;
+			}
+			else if(diff<0)
+				return SIZE_MAX-1;
+			else
+				pos=tail.load(std::memory_order_relaxed);
+		}
+	}
+	bool try_lock_exclusive() noexcept
+	{
+		std::size_t pos{tail.load(std::memory_order_relaxed)};
+		return !(pos&flags)&&tail.compare_exchange_weak(pos,pos|exclusive,std::memory_order_relaxed,std::memory_order_relaxed);
+	}
+	void unlock_exclusive() noexcept
+	{
+		tail.fetch_and(~exclusive,std::memory_order_relaxed);
+	}
+	void publish(std::size_t pos,std::size_t length,std::size_t k) noexcept
+	{
+		headers[pos&(slots-1)]={length,k};
+		sequences[pos&(slots-1)].store(pos+1,std::memory_order_release);
+	}
+};
+
+}
+
+template<output_stream T,ring_log_overflow policy=ring_log_overflow::block,std::size_t slot_size=128,std::size_t slots=16384>
+requires (slot_size!=0&&slots!=0&&(slots&(slots-1))==0)
+class basic_ring_log
+{
+public:
+	using native_handle_type = T;
+	using char_type = typename native_handle_type::char_type;
+	using segment_type = details::ring_log_segment<char_type,slot_size>;
+	static inline constexpr std::size_t capacity{slots*slot_size};
+	struct claim_type
+	{
+		segment_type* segment{};
+		std::size_t position{};
+		std::size_t count{};
+		char_type* ptr{};
+	};
+private:
+	T handler;
+	std::unique_ptr<segment_type> first;
+	alignas(64) std::atomic<segment_type*> current{};
+	alignas(64) std::atomic<std::size_t> dropped_records{};
+//producers between claim and publish, counted under grow only
+	alignas(64) std::atomic<std::size_t> claimers{};
+	std::atomic<bool> stopping{};
+	std::mutex grow_mtx;
+#ifdef __cpp_exceptions
+	std::mutex error_mtx;
+	std::exception_ptr error;
+#endif
+	std::thread consumer;
+
+	void grow(segment_type* seg,std::size_t k)
+	{
+		std::lock_guard lg{grow_mtx};
+		if(current.load(std::memory_order_relaxed)!=seg)
+			return;
+		std::size_t n{seg->slots<<1};
+		if(n<k)
+			n=std::bit_ceil(k);
+		seg->next=std::make_unique<segment_type>(n);
+//seq_cst pairs with claimers: a producer counted in after the consumer saw none can only load the new ring
+		current.store(seg->next.get(),std::memory_order_seq_cst);
+		seg->tail.fetch_or(segment_type::closed,std::memory_order_release);
+	}
+	void sink_flush()
+	{
+		if constexpr(requires(T& h)
+		{
+			flush(h);
+		})
+			flush(handler);
+	}
+//retired rings are a prefix of the chain that first owns. The consumer is the only one that touches first.
+	void free_retired(segment_type* seg) noexcept
+	{
+		if(first.get()==seg||claimers.load(std::memory_order_seq_cst))
+			return;
+		while(first.get()!=seg)
+			first=std::move(first->next);
+	}
+	claim_type claim_impl(std::size_t n)
+	{
+		std::size_t k{(n+(slot_size-1))/slot_size};
+		if(k==0)
+			k=1;
+		for(;;)
+		{
+			auto seg{current.load(std::memory_order_seq_cst)};
+			if(seg->slots<k)
+			{
+				if constexpr(policy==ring_log_overflow::grow)
+				{
+					grow(seg,k);
+					continue;
+				}
+				else
+				{
+					dropped_records.fetch_add(1,std::memory_order_relaxed);
+					return {};
+				}
+			}
+			std::size_t const pos{seg->try_claim(k)};
+			if(pos==segment_type::closed)
+				continue;
+			if(pos!=SIZE_MAX-1)[[likely]]
+				return {seg,pos,k,seg->slot_data(pos)};
+			if constexpr(policy==ring_log_overflow::block)
+				std::this_thread::yield();
+			else if constexpr(policy==ring_log_overflow::drop)
+			{
+				dropped_records.fetch_add(1,std::memory_order_relaxed);
+				return {};
+			}
+			else
+				grow(seg,k);
+		}
+	}
+//a record larger than the ring can never fit in one piece. Block never grows, so the ring is always first.
+	void write_split(char_type const* first_ptr,std::size_t n) noexcept
+	{
+		auto seg{first.get()};
+		while(!seg->try_lock_exclusive())
+			std::this_thread::yield();
+		for(;n;)
+		{
+			std::size_t const m{n<capacity?n:capacity};
+			std::size_t const k{(m+(slot_size-1))/slot_size};
+			std::size_t pos;
+			while((pos=seg->template try_claim<true>(k))==SIZE_MAX-1)
+				std::this_thread::yield();
+			details::non_overlapped_copy_n(first_ptr,m,seg->slot_data(pos));
+			seg->publish(pos,m,k);
+			first_ptr+=m;
+			n-=m;
+		}
+		seg->unlock_exclusive();
+	}
+	void store_error() noexcept
+	{
+#ifdef __cpp_exceptions
+		std::lock_guard lg{error_mtx};
+		if(!error)
+			error=std::current_exception();
+#endif
+	}
+	void rethrow_error()
+	{
+#ifdef __cpp_exceptions
+		std::lock_guard lg{error_mtx};
+		if(error)
+		{
+			auto eptr{std::move(error)};
+			error=nullptr;
+			std::rethrow_exception(eptr);
+		}
+#endif
+	}
+	void stop() noexcept
+	{
+		if(!consumer.joinable())
+			return;
+		stopping.store(true,std::memory_order_release);
+		consumer.join();
+	}
+	void consume_loop() noexcept
+	{
+		segment_type* seg{first.get()};
+		std::size_t head{};
+		std::size_t unflushed{};
+		for(std::size_t idle{};;)
+		{
+			std::size_t const seq{seg->sequences[head&(seg->slots-1)].load(std::memory_order_acquire)};
+			if(seq==head+1)
+			{
+				auto const [length,k]{seg->headers[head&(seg->slots-1)]};
+				auto p{seg->slot_data(head)};
+#ifdef __cpp_exceptions
+				try
+				{
+#endif
+					write_all(handler,p,p+length);
+#ifdef __cpp_exceptions
+				}
+				catch(...)
+				{
+					store_error();
+				}
+#endif
+				for(std::size_t i{};i!=k;++i)
+					seg->sequences[(head+i)&(seg->slots-1)].store(head+i+seg->slots,std::memory_order_release);
+				head+=k;
+				unflushed+=length;
+				idle=0;
+				if(unflushed<1048576)
+					continue;
+			}
+			std::size_t const tail{seg->tail.load(std::memory_order_acquire)};
+			if(unflushed)
+			{
+#ifdef __cpp_exceptions
+				try
+				{
+#endif
+					sink_flush();
+#ifdef __cpp_exceptions
+				}
+				catch(...)
+				{
+					store_error();
+				}
+#endif
+				unflushed=0;
+				seg->consumed.store(head,std::memory_order_release);
+				continue;
+			}
+			seg->consumed.store(head,std::memory_order_release);
+			if(head==(tail&~segment_type::flags))
+			{
+				if(tail&segment_type::closed)
+				{
+					seg->finished.store(true,std::memory_order_release);
+					seg=seg->next.get();
+					head=0;
+					continue;
+				}
+				if(stopping.load(std::memory_order_acquire))
+					return;
+			}
+			if constexpr(policy==ring_log_overflow::grow)
+				free_retired(seg);
+			if(++idle<64)
+				std::this_thread::yield();
+			else
+				std::this_thread::sleep_for(std::chrono::microseconds(idle<1024?50:1000));
+		}
+	}
+public:
+	template<typename ...Args>
+	requires std::constructible_from<T,Args...>
+	basic_ring_log(Args&& ...args):handler(std::forward<Args>(args)...),first(std::make_unique<segment_type>(slots))
+	{
+		current.store(first.get(),std::memory_order_relaxed);
+		consumer=std::thread([this]{consume_loop();});
+	}
+	basic_ring_log(basic_ring_log const&)=delete;
+	basic_ring_log& operator=(basic_ring_log const&)=delete;
+	~basic_ring_log()
+	{
+		stop();
+	}
+//write out every record, stop the consumer and rethrow the error of the sink that flush has not reported yet
+	void close()
+	{
+		stop();
+		rethrow_error();
+	}
+//the sink. Only safe to touch while no record is in flight.
+	native_handle_type& native_handle() noexcept
+	{
+		return handler;
+	}
+	std::size_t dropped() const noexcept
+	{
+		return dropped_records.load(std::memory_order_relaxed);
+	}
+//room for at most bytes characters. ptr is nullptr when the record was dropped, otherwise publish must follow.
+	claim_type claim(std::size_t n)
+	{
+		if constexpr(policy==ring_log_overflow::grow)
+		{
+			claimers.fetch_add(1,std::memory_order_seq_cst);
+#ifdef __cpp_exceptions
+			try
+			{
+#endif
+				return claim_impl(n);
+#ifdef __cpp_exceptions
+			}
+			catch(...)
+			{
+				claimers.fetch_sub(1,std::memory_order_release);
+				throw;
+			}
+#endif
+		}
+		else
+			return claim_impl(n);
+	}
+	void publish(claim_type const& c,std::size_t n) noexcept
+	{
+		c.segment->publish(c.position,n,c.count);
+		if constexpr(policy==ring_log_overflow::grow)
+			claimers.fetch_sub(1,std::memory_order_release);
+	}
+	void write_record(char_type const* first_ptr,char_type const* last_ptr)
+	{
+		std::size_t n(last_ptr-first_ptr);
+		if constexpr(policy==ring_log_overflow::block)
+		{
+			if(capacity<n)
+			{
+				write_split(first_ptr,n);
+				return;
+			}
+		}
+		auto c{claim(n)};
+		if(c.ptr==nullptr)
+			return;
+		details::non_overlapped_copy_n(first_ptr,n,c.ptr);
+		publish(c,n);
+	}
+	template<bool line,typename... Args>
+	void record(Args&& ...args)
+	{
+		if constexpr(sizeof...(Args)!=0&&(reserve_printable<Args>&&...))
+		{
+			constexpr std::size_t bound{(print_reserve_size(io_reserve_type<std::remove_cvref_t<Args>>)+...)+line};
+			if constexpr(bound<=capacity)
+			{
+				auto c{claim(bound)};
+				if(c.ptr==nullptr)
+					return;
+				auto it{c.ptr};
+				((it=print_reserve_define(io_reserve_type<std::remove_cvref_t<Args>>,it,args)),...);
+				if constexpr(line)
+				{
+					*it=u8'\n';
+					++it;
+				}
+				publish(c,static_cast<std::size_t>(it-c.ptr));
+				return;
+			}
+		}
+		auto& staging{details::ring_log_staging<char_type>()};
+		staging.curr=staging.beg;
+		if constexpr(line)
+			println(staging,std::forward<Args>(args)...);
+		else
+			print(staging,std::forward<Args>(args)...);
+		write_record(staging.beg,staging.curr);
+	}
+//wait until the records published so far have been written to the sink and flushed
+	void drain()
+	{
+//counted like a producer, so the ring it watches is not freed under it
+		if constexpr(policy==ring_log_overflow::grow)
+			claimers.fetch_add(1,std::memory_order_seq_cst);
+		auto seg{current.load(std::memory_order_seq_cst)};
+		std::size_t const pos{seg->tail.load(std::memory_order_acquire)&~segment_type::flags};
+		while(!seg->finished.load(std::memory_order_acquire)&&seg->consumed.load(std::memory_order_acquire)<pos)
+			std::this_thread::yield();
+		if constexpr(policy==ring_log_overflow::grow)
+			claimers.fetch_sub(1,std::memory_order_release);
+		rethrow_error();
+	}
+};
+
+template<output_stream T,ring_log_overflow policy,std::size_t slot_size,std::size_t slots,typename... Args>
+inline void print(basic_ring_log<T,policy,slot_size,slots>& log,Args&& ...args)
+{
+	log.template record<false>(std::forward<Args>(args)...);
+}
+
+template<output_stream T,ring_log_overflow policy,std::size_t slot_size,std::size_t slots,typename... Args>
+inline void println(basic_ring_log<T,policy,slot_size,slots>& log,Args&& ...args)
+{
+	log.template record<true>(std::forward<Args>(args)...);
+}
+
+template<output_stream T,ring_log_overflow policy,std::size_t slot_size,std::size_t slots,std::contiguous_iterator Iter>
+requires (write_read_punned_constraints<basic_ring_log<T,policy,slot_size,slots>,Iter>)
+inline void write(basic_ring_log<T,policy,slot_size,slots>& log,Iter cbegin,Iter cend)
+{
+	using char_type = typename T::char_type;
+	if constexpr(std::same_as<char_type,std::iter_value_t<Iter>>)
+		log.write_record(std::to_address(cbegin),std::to_address(cend));
+	else
+		log.write_record(reinterpret_cast<char_type const*>(std::to_address(cbegin)),
+			reinterpret_cast<char_type const*>(std::to_address(cend)));
+}
+
+template<output_stream T,ring_log_overflow policy,std::size_t slot_size,std::size_t slots>
+inline void flush(basic_ring_log<T,policy,slot_size,slots>& log)
+{
+	log.drain();
+}
+
+}
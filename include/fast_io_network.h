@@ -26,6 +26,7 @@ using ibuf_tcp_client = basic_ibuf<tcp_client>;
 
 using async_tcp_server = basic_tcp_server<true>;
 using async_acceptor = basic_acceptor<char,true>;
+using async_tcp_client = basic_tcp_client<char,true>;
 
 /*
 using u8tcp_acceptor = basic_acceptor<char8_t,false>;
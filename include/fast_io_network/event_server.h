@@ -0,0 +1,389 @@
+#pragma once
+#include<sys/epoll.h>
+#include<sys/eventfd.h>
+#include<netinet/tcp.h>
+
+namespace fast_io
+{
+
+/*
+event_server runs one event loop per worker thread. Every worker owns an SO_REUSEPORT listener, so the kernel spreads
+new connections across the workers and no thread hands sockets to another. Connections are nonblocking and watched
+edge triggered with epoll. Whenever bytes arrive, the handler is called as func(connection,bytes) on the worker that
+owns the connection. Anything the handler writes to the connection is buffered and sent when the handler returns.
+What the socket does not take right away is sent on EPOLLOUT.
+A connection is closed when the peer closes it, when the handler calls close() (after pending output is sent), or
+when the handler throws.
+run() blocks with the calling thread as worker 0 until stop() is called from any thread.
+*/
+
+struct event_server_options
+{
+	std::size_t threads{};		//0 means std::thread::hardware_concurrency()
+	int backlog{4096};
+	std::size_t read_buffer_size{65536};
+	std::size_t max_events{1024};
+};
+
+class event_connection
+{
+public:
+	using char_type = char;
+	using native_handle_type = int;
+	int fd{-1};
+	address_info cinfo;
+	std::vector<char> pending;
+	std::size_t pending_offset{};
+	std::size_t index{};
+	bool closing{};
+	bool want_output{};
+	constexpr event_connection() noexcept=default;
+	event_connection(event_connection const&)=delete;
+	event_connection& operator=(event_connection const&)=delete;
+	~event_connection()
+	{
+		if(fd!=-1)
+			::close(fd);
+	}
+	constexpr int native_handle() const noexcept
+	{
+		return fd;
+	}
+	constexpr auto& info() noexcept
+	{
+		return cinfo;
+	}
+	constexpr auto const& info() const noexcept
+	{
+		return cinfo;
+	}
+//close once the pending output has been sent
+	constexpr void close() noexcept
+	{
+		closing=true;
+	}
+};
+
+template<std::contiguous_iterator Iter>
+inline void write(event_connection& conn,Iter begin,Iter end)
+{
+	auto const b{reinterpret_cast<char const*>(std::to_address(begin))};
+	auto const e{reinterpret_cast<char const*>(std::to_address(end))};
+	conn.pending.insert(conn.pending.end(),b,e);
+}
+
+inline constexpr void flush(event_connection&) noexcept{}
+
+namespace details
+{
+
+inline int event_server_listener(socket_address_storage const& stg,std::size_t address_size,int backlog)
+{
+	int fd{::socket(stg.sock.sa_family,SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC,0)};
+	if(fd==-1)
+		throw_posix_error();
+	int const one{1};
+	if(::setsockopt(fd,SOL_SOCKET,SO_REUSEADDR,std::addressof(one),sizeof(one))==-1||
+		::setsockopt(fd,SOL_SOCKET,SO_REUSEPORT,std::addressof(one),sizeof(one))==-1||
+		::bind(fd,std::addressof(stg.sock),static_cast<socklen_t>(address_size))==-1||
+		::listen(fd,backlog)==-1)
+	{
+		int const ec{errno};
+		::close(fd);
+		throw_posix_error(ec);
+	}
+	return fd;
+}
+
+struct event_server_worker
+{
+	int listener{-1};
+	int epoll{-1};
+	int wakeup{-1};
+	int spare{-1};
+	std::vector<std::unique_ptr<event_connection>> connections;
+	event_server_worker()=default;
+	event_server_worker(event_server_worker const&)=delete;
+	event_server_worker& operator=(event_server_worker const&)=delete;
+	~event_server_worker()
+	{
+		for(int fd : {listener,epoll,wakeup,spare})
+			if(fd!=-1)
+				::close(fd);
+	}
+	void watch(int fd,std::uint32_t events,void* ptr)
+	{
+		epoll_event ev{};
+		ev.events=events;
+		ev.data.ptr=ptr;
+		if(::epoll_ctl(epoll,EPOLL_CTL_ADD,fd,std::addressof(ev))==-1)
+			throw_posix_error();
+	}
+	void rewatch(event_connection& conn)
+	{
+		epoll_event ev{};
+		ev.events=EPOLLIN|EPOLLRDHUP|EPOLLET|(conn.want_output?static_cast<std::uint32_t>(EPOLLOUT):0u);
+		ev.data.ptr=std::addressof(conn);
+		if(::epoll_ctl(epoll,EPOLL_CTL_MOD,conn.fd,std::addressof(ev))==-1)
+			throw_posix_error();
+	}
+	void remove(event_connection& conn) noexcept
+	{
+		std::size_t const i{conn.index};
+		if(i+1!=connections.size())
+		{
+			connections[i]=std::move(connections.back());
+			connections[i]->index=i;
+		}
+		connections.pop_back();
+	}
+/*
+Out of fds, the pending connection stays queued and the level-triggered listener would wake epoll_wait forever.
+The spare fd is given up to accept that connection and close it right away, then taken again.
+Returns false when no connection was waiting, since accept reports EMFILE before it looks at the queue.
+*/
+	bool drop_one() noexcept
+	{
+		if(spare==-1)
+			return false;
+		::close(spare);
+		int fd{::accept4(listener,nullptr,nullptr,SOCK_CLOEXEC)};
+		if(fd!=-1)
+			::close(fd);
+		spare=::open("/dev/null",O_RDONLY|O_CLOEXEC);
+		return fd!=-1;
+	}
+	void accept_all()
+	{
+		for(;;)
+		{
+			auto conn{std::make_unique<event_connection>()};
+			conn->cinfo.storage_size=sizeof(socket_address_storage);
+			int fd{::accept4(listener,std::addressof(conn->cinfo.storage.sock),std::addressof(conn->cinfo.storage_size),
+				SOCK_NONBLOCK|SOCK_CLOEXEC)};
+			if(fd==-1)
+			{
+				if(errno==EAGAIN||errno==EWOULDBLOCK)
+					return;
+				if(errno==EINTR||errno==ECONNABORTED)
+					continue;
+				if(errno==EMFILE||errno==ENFILE)
+				{
+					if(drop_one())
+						continue;
+					return;
+				}
+				throw_posix_error();
+			}
+			conn->fd=fd;
+			int const one{1};
+			::setsockopt(fd,IPPROTO_TCP,TCP_NODELAY,std::addressof(one),sizeof(one));
+			conn->index=connections.size();
+			connections.reserve(connections.size()+1);
+			watch(fd,EPOLLIN|EPOLLRDHUP|EPOLLET,conn.get());
+			connections.push_back(std::move(conn));
+		}
+	}
+//send what is pending. Returns false when the socket failed.
+	static bool send_pending(event_connection& conn) noexcept
+	{
+		for(;conn.pending_offset!=conn.pending.size();)
+		{
+			auto const r{::send(conn.fd,conn.pending.data()+conn.pending_offset,conn.pending.size()-conn.pending_offset,MSG_NOSIGNAL)};
+			if(r==-1)
+			{
+				if(errno==EINTR)
+					continue;
+				return errno==EAGAIN||errno==EWOULDBLOCK;
+			}
+			conn.pending_offset+=static_cast<std::size_t>(r);
+		}
+		conn.pending.clear();
+		conn.pending_offset=0;
+		return true;
+	}
+	template<typename Func>
+	void serve(event_connection& conn,std::uint32_t events,Func& func,char* buffer,std::size_t buffer_size)
+	{
+		bool alive{!(events&EPOLLERR)};
+		if(alive&&(events&(EPOLLIN|EPOLLRDHUP|EPOLLHUP)))
+		{
+			for(;;)
+			{
+				auto const r{::recv(conn.fd,buffer,buffer_size,0)};
+				if(r==-1)
+				{
+					if(errno==EINTR)
+						continue;
+					alive=errno==EAGAIN||errno==EWOULDBLOCK;
+					break;
+				}
+				if(r==0)
+				{
+//the peer is done sending. What the handler wrote is still sent before the connection closes.
+					conn.closing=true;
+					break;
+				}
+#ifdef __cpp_exceptions
+				try
+				{
+#endif
+					func(conn,std::span<char const>(buffer,static_cast<std::size_t>(r)));
+#ifdef __cpp_exceptions
+				}
+				catch(...)
+				{
+					alive=false;
+					break;
+				}
+#endif
+				if(conn.closing)
+					break;
+//a FIN that came in the same edge as the data shows up only as recv returning 0, so read on until EAGAIN
+				if(static_cast<std::size_t>(r)!=buffer_size&&!(events&(EPOLLRDHUP|EPOLLHUP)))
+					break;
+			}
+		}
+		if(alive)
+			alive=send_pending(conn);
+		if(alive&&conn.closing&&conn.pending.empty())
+			alive=false;
+		if(!alive)
+		{
+			remove(conn);
+			return;
+		}
+		bool const want{!conn.pending.empty()};
+		if(want!=conn.want_output)
+		{
+			conn.want_output=want;
+			rewatch(conn);
+		}
+	}
+	template<typename Func>
+	void loop(Func& func,event_server_options const& options)
+	{
+		std::size_t const buffer_size{options.read_buffer_size?options.read_buffer_size:65536};
+		std::unique_ptr<char[]> buffer(new char[buffer_size]);
+		std::size_t const max_events{options.max_events?options.max_events:1024};
+		std::unique_ptr<epoll_event[]> events(new epoll_event[max_events]);
+		for(;;)
+		{
+			int const n{::epoll_wait(epoll,events.get(),static_cast<int>(max_events),-1)};
+			if(n==-1)
+			{
+				if(errno==EINTR)
+					continue;
+				throw_posix_error();
+			}
+			for(int i{};i!=n;++i)
+			{
+				auto const& ev{events[i]};
+				if(ev.data.ptr==this)
+				{
+					std::uint64_t value;
+					[[maybe_unused]] auto r{::read(wakeup,std::addressof(value),sizeof(value))};
+					connections.clear();
+					return;
+				}
+				if(ev.data.ptr==nullptr)
+					accept_all();
+				else
+					serve(*static_cast<event_connection*>(ev.data.ptr),ev.events,func,buffer.get(),buffer_size);
+			}
+		}
+	}
+};
+
+}
+
+class event_server
+{
+	std::unique_ptr<details::event_server_worker[]> workers;
+	std::size_t worker_count{};
+	event_server_options opts;
+	void open(socket_address_storage const& stg,std::size_t address_size)
+	{
+		worker_count=opts.threads?opts.threads:std::thread::hardware_concurrency();
+		if(worker_count==0)
+			worker_count=1;
+		workers=std::make_unique<details::event_server_worker[]>(worker_count);
+		for(std::size_t i{};i!=worker_count;++i)
+		{
+			auto& w{workers[i]};
+			w.listener=details::event_server_listener(stg,address_size,opts.backlog);
+			if((w.epoll=::epoll_create1(EPOLL_CLOEXEC))==-1)
+				throw_posix_error();
+			if((w.wakeup=::eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC))==-1)
+				throw_posix_error();
+			if((w.spare=::open("/dev/null",O_RDONLY|O_CLOEXEC))==-1)
+				throw_posix_error();
+			w.watch(w.listener,EPOLLIN,nullptr);
+			w.watch(w.wakeup,EPOLLIN,std::addressof(w));
+		}
+	}
+public:
+	template<typename addrType,std::integral U>
+	requires (!std::integral<addrType>)
+	event_server(addrType const& add,U port,event_server_options const& options={}):opts(options)
+	{
+		open(to_socket_address_storage(add,port),native_socket_address_size(add));
+	}
+	template<std::integral U>
+	explicit event_server(U port,event_server_options const& options={}):event_server(ipv4{},port,options){}
+	event_server(event_server const&)=delete;
+	event_server& operator=(event_server const&)=delete;
+	std::size_t threads() const noexcept
+	{
+		return worker_count;
+	}
+//serve until stop(). Connections still open are closed on return.
+	template<typename Func>
+	requires std::invocable<Func&,event_connection&,std::span<char const>>
+	void run(Func func)
+	{
+		std::exception_ptr error;
+		std::mutex mtx;
+		auto body{[&](std::size_t i) noexcept
+		{
+#ifdef __cpp_exceptions
+			try
+			{
+#endif
+				workers[i].loop(func,opts);
+#ifdef __cpp_exceptions
+			}
+			catch(...)
+			{
+				{
+					std::lock_guard lg{mtx};
+					if(!error)
+						error=std::current_exception();
+				}
+				stop();
+			}
+#endif
+		}};
+		{
+			std::vector<std::jthread> threads;
+			threads.reserve(worker_count-1);
+			for(std::size_t i{1};i<worker_count;++i)
+				threads.emplace_back(body,i);
+			body(0);
+		}
+#ifdef __cpp_exceptions
+		if(error)
+			std::rethrow_exception(error);
+#endif
+	}
+	void stop() noexcept
+	{
+		for(std::size_t i{};i!=worker_count;++i)
+		{
+			std::uint64_t const one{1};
+			[[maybe_unused]] auto r{::write(workers[i].wakeup,std::addressof(one),sizeof(one))};
+		}
+	}
+};
+
+}
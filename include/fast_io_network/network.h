@@ -60,4 +60,7 @@ udp = IPPROTO_UDP,
 #include"socket.h"
 #include"dns.h"
 #include"http.h"
-#include"thread_pool.h"
\ No newline at end of file
+#include"thread_pool.h"
+#if defined(__linux__)
+#include"event_server.h"
+#endif
\ No newline at end of file
@@ -327,6 +327,8 @@ public:
 	basic_connected_client(T const& add,U u,Args&& ...args):basic_connected_socket<async>(family(add),std::forward<Args>(args)...),cinfo{to_socket_address_storage(add,u),sizeof(socket_address_storage)}
 	{
 		sock::details::connect(native_handle(),cinfo.storage,native_socket_address_size(add));
+		if constexpr(async)
+			unblock(*this);
 	}
 	constexpr auto& info()
 	{
@@ -6,6 +6,7 @@ namespace fast_io
 /*
 https://www.youtube.com/watch?v=c1gO9aB9nbs&t=3166s
 CppCon 2014: Herb Sutter "Lock-Free Programming (or, Juggling Razor Blades), Part I"
+Spends a thread per connection in flight. On Linux, event_server serves many connections per thread instead.
 */
 template<std::movable acceptor_type,std::size_t size=900,typename server_type,typename Func>
 inline void thread_pool_accept(server_type& server,Func&& func)
@@ -0,0 +1,62 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+
+/*
+A 64 KiB window over a file of several MiB puts many tokens across a window boundary, some of them longer than a
+few characters. Scanning must join the two halves of every such token, and read must return the file byte for byte.
+*/
+
+inline std::size_t value_of(std::size_t i) noexcept
+{
+	return i*2654435761u%1000000007u;
+}
+
+int main()
+{
+	constexpr std::size_t values{400000};
+	std::string expected;
+	{
+		fast_io::obuf_file obf("imap_window.txt");
+		for(std::size_t i{};i!=values;++i)
+		{
+			if(i%1000==0)
+				println(obf,i," ",std::string(1+i%3000,'w'));
+			else
+				println(obf,value_of(i));
+		}
+	}
+	{
+		fast_io::basic_imap_window<fast_io::inative_file,fast_io::native_file_map,65536> im("imap_window.txt");
+		for(std::size_t i{};i!=values;++i)
+		{
+			std::size_t value{};
+			scan(im,value);
+			if(i%1000==0)
+			{
+				std::string s;
+				scan(im,s);
+				if(value!=i||s.size()!=1+i%3000)
+					panicln("token ",i," is split wrongly");
+			}
+			else if(value!=value_of(i))
+				panicln("value ",i," reads back as ",value);
+		}
+		std::size_t extra{};
+		if(scan<true>(im,extra))
+			panicln("values after the last one");
+	}
+	{
+		fast_io::inative_file nf("imap_window.txt");
+		char buffer[65536];
+		for(char* e;(e=read(nf,buffer,buffer+sizeof(buffer)))!=buffer;)
+			expected.append(buffer,e);
+	}
+	fast_io::basic_imap_window<fast_io::inative_file,fast_io::native_file_map,65536> im("imap_window.txt");
+	std::string got;
+	char buffer[10007];
+	for(char* e;(e=read(im,buffer,buffer+sizeof(buffer)))!=buffer;)
+		got.append(buffer,e);
+	if(got!=expected)
+		panicln("read gave ",got.size()," bytes that differ from the ",expected.size()," in the file");
+	println(fast_io::out(),"ok");
+}
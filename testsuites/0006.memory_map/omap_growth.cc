@@ -0,0 +1,41 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+
+/*
+omap_file starts with a small mapping and grows it while printing. Many small records and some payloads larger than the
+current mapping make it grow several times. The closed file must be truncated to what was printed and read back exactly.
+*/
+
+int main()
+{
+	std::string expected;
+	{
+		fast_io::omap_file om("omap_growth.txt");
+		for(std::size_t i{};i!=2000000;++i)
+		{
+			char buffer[32];
+			auto e{fast_io::print_reserve_define(fast_io::io_reserve_type<std::size_t>,buffer,i)};
+			*e++='\n';
+			write(om,buffer,e);
+			expected.append(buffer,e);
+			if(i%500000==0)
+			{
+				std::string large(3145728+i,static_cast<char>('a'+i%26));
+				large.back()='\n';
+				write(om,large.data(),large.data()+large.size());
+				expected.append(large);
+			}
+		}
+	}
+	fast_io::inative_file nf("omap_growth.txt");
+	if(static_cast<std::size_t>(seek(nf,0,fast_io::seekdir::end))!=expected.size())
+		panicln("the file is not truncated to the ",expected.size()," bytes printed");
+	seek(nf,0,fast_io::seekdir::beg);
+	std::string got;
+	char buffer[65536];
+	for(char* e;(e=read(nf,buffer,buffer+sizeof(buffer)))!=buffer;)
+		got.append(buffer,e);
+	if(got!=expected)
+		panicln("the file differs from what was printed");
+	println(fast_io::out(),"ok");
+}
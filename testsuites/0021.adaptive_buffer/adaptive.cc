@@ -0,0 +1,28 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+
+int main()
+{
+	std::string large(1048576,'a');
+	{
+		fast_io::obuf_adaptive_file obf("adaptive.txt");
+		std::size_t const initial_capacity{obf.obuffer.capacity()};
+		println(fast_io::out(),"initial capacity:",initial_capacity);
+		for(std::size_t i{};i!=100000;++i)
+			println(obf,i);
+		for(std::size_t i{};i!=4;++i)
+			print(obf,large);
+		println(fast_io::out(),"grown capacity:",obf.obuffer.capacity());
+		if(obf.obuffer.capacity()<=initial_capacity)
+			panicln("large writes did not grow the buffer");
+	}
+	fast_io::ibuf_adaptive_file ibf("adaptive.txt");
+	std::size_t value{};
+	for(std::size_t i{};i!=100000;++i)
+	{
+		scan(ibf,value);
+		if(value!=i)
+			panicln("adaptive buffer round trip failed at ",i);
+	}
+	println(fast_io::out(),"ok");
+}
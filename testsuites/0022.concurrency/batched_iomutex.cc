@@ -0,0 +1,72 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+#include<latch>
+#include<thread>
+#include<vector>
+
+/*
+Waves of threads print numbered records into one obatched_file_mutex. Every thread of a later wave reuses a buffer
+freed by a thread that exited before it. The file must hold every record once, whole, and in order per thread.
+A flush from one thread must also commit what other, still running threads have printed.
+*/
+
+inline void flush_all_threads()
+{
+	constexpr std::size_t threads{4};
+	constexpr std::size_t records{1000};
+	fast_io::obatched_file_mutex log("batched_iomutex_flush.txt");
+	std::latch printed(threads),checked(1);
+	std::vector<std::jthread> pool;
+	for(std::size_t t{};t!=threads;++t)
+		pool.emplace_back([&,t]
+		{
+			for(std::size_t i{};i!=records;++i)
+				println(log,t," ",i);
+			printed.count_down();
+			checked.wait();
+		});
+	printed.wait();
+	flush(log);
+	fast_io::ibuf_file ibf("batched_iomutex_flush.txt");
+	std::size_t lines{};
+	for(std::size_t t,i;scan<true>(ibf,t,i);)
+		++lines;
+	checked.count_down();
+	if(lines!=threads*records)
+		panicln("flush committed ",lines," of ",threads*records," records");
+}
+
+int main()
+{
+	constexpr std::size_t waves{8};
+	constexpr std::size_t threads{16};
+	constexpr std::size_t records{20000};
+	{
+		fast_io::obatched_file_mutex log("batched_iomutex.txt");
+		for(std::size_t w{};w!=waves;++w)
+		{
+			std::vector<std::jthread> pool;
+			for(std::size_t t{};t!=threads;++t)
+				pool.emplace_back([&log,id=w*threads+t]
+				{
+					for(std::size_t i{};i!=records;++i)
+						println(log,id," ",i," ",id^i);
+				});
+		}
+	}
+	std::vector<std::size_t> next(waves*threads);
+	fast_io::ibuf_file ibf("batched_iomutex.txt");
+	for(std::size_t line{};line!=waves*threads*records;++line)
+	{
+		std::size_t id{},i{},check{};
+		scan(ibf,id,i,check);
+		if(next.size()<=id||next[id]!=i||check!=(id^i))
+			panicln("record ",line," is torn or out of order: ",id," ",i," ",check);
+		++next[id];
+	}
+	std::size_t extra{};
+	if(scan<true>(ibf,extra))
+		panicln("records after the last one");
+	flush_all_threads();
+	println(fast_io::out(),"ok");
+}
@@ -0,0 +1,79 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+#include<atomic>
+#include<chrono>
+#include<thread>
+#include<vector>
+
+/*
+io_mutex must exclude every other thread, both while it spins and once waiters sleep on the futex. A lock taken while
+the process had a single thread must still block threads started later, and its unlock must wake them. Lines printed
+into one obuf_file_mutex by many threads must come out whole.
+*/
+
+int main()
+{
+	fast_io::io_mutex mtx;
+	mtx.lock();
+	std::atomic<bool> entered{};
+	{
+		std::jthread waiter([&]
+		{
+			mtx.lock();
+			entered.store(true,std::memory_order_relaxed);
+			mtx.unlock();
+		});
+		using namespace std::chrono_literals;
+		std::this_thread::sleep_for(50ms);
+		if(entered.load(std::memory_order_relaxed))
+			panicln("a lock taken by a single threaded process did not block a later thread");
+		mtx.unlock();
+	}
+	if(!entered.load(std::memory_order_relaxed))
+		panicln("the waiter never got the lock");
+	constexpr std::size_t threads{8};
+	constexpr std::size_t rounds{200000};
+	std::size_t counter{};
+	std::size_t inside{};
+	{
+		std::vector<std::jthread> pool;
+		for(std::size_t t{};t!=threads;++t)
+			pool.emplace_back([&,t]
+			{
+				for(std::size_t i{};i!=rounds;++i)
+				{
+					if(!(t%2&&mtx.try_lock()))
+						mtx.lock();
+					if(inside++)
+						panicln("two threads hold the lock");
+					++counter;
+//a long critical section now and then makes the others give up spinning and sleep
+					if(i%4096==0)
+						std::this_thread::yield();
+					--inside;
+					mtx.unlock();
+				}
+			});
+	}
+	if(counter!=threads*rounds)
+		panicln("the counter is ",counter," instead of ",threads*rounds);
+	{
+		fast_io::obuf_file_mutex obf("io_mutex.txt");
+		std::vector<std::jthread> pool;
+		for(std::size_t t{};t!=threads;++t)
+			pool.emplace_back([&obf,t]
+			{
+				for(std::size_t i{};i!=20000;++i)
+					println(obf,t," ",i," ",t*i);
+			});
+	}
+	fast_io::ibuf_file ibf("io_mutex.txt");
+	std::vector<std::size_t> next(threads);
+	std::size_t lines{};
+	for(std::size_t t,i,product;scan<true>(ibf,t,i,product);++lines)
+		if(threads<=t||next[t]++!=i||product!=t*i)
+			panicln("line ",lines," is torn or out of order");
+	if(lines!=threads*20000)
+		panicln("the file has ",lines," lines instead of ",threads*20000);
+	println(fast_io::out(),"ok");
+}
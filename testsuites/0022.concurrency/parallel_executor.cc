@@ -0,0 +1,92 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+#include<atomic>
+#include<memory>
+#include<thread>
+#include<vector>
+
+/*
+Every task of a job must run exactly once, also while other workers steal it. An exception thrown by one task comes
+out of run once the job is done, and the executor stays usable. Jobs run from several threads at once must not mix.
+parallel output must match the sequential one.
+*/
+
+int main()
+{
+	fast_io::parallel_executor ex(8);
+	constexpr std::size_t tasks{4096};
+	auto runs{std::make_unique<std::atomic<std::size_t>[]>(tasks)};
+	for(std::size_t job{};job!=200;++job)
+	{
+		ex.set_concurrency_limit(job%9);
+		auto func{[&](std::size_t task,std::size_t worker)
+		{
+			if(ex.concurrency()<=worker)
+				panicln("worker ",worker," runs above the limit ",ex.concurrency());
+			runs[task].fetch_add(1,std::memory_order_relaxed);
+		}};
+		ex.run(tasks,func);
+		for(std::size_t i{};i!=tasks;++i)
+			if(runs[i].exchange(0,std::memory_order_relaxed)!=1)
+				panicln("job ",job," task ",i," did not run exactly once");
+	}
+	ex.set_concurrency_limit(0);
+	{
+		std::vector<std::jthread> callers;
+		for(std::size_t c{};c!=4;++c)
+			callers.emplace_back([&ex,c]
+			{
+				for(std::size_t job{};job!=50;++job)
+				{
+					std::vector<std::size_t> seen(512);
+					auto func{[&](std::size_t task,std::size_t)
+					{
+						seen[task]+=c+1;
+					}};
+					ex.run(seen.size(),func);
+					for(auto e : seen)
+						if(e!=c+1)
+							panicln("caller ",c," job ",job," ran a task of another job");
+				}
+			});
+	}
+#ifdef __cpp_exceptions
+	std::atomic<std::size_t> done{};
+	auto thrower{[&](std::size_t task,std::size_t)
+	{
+		if(task==17)
+			throw fast_io::posix_error(EINVAL);
+		done.fetch_add(1,std::memory_order_relaxed);
+	}};
+	bool thrown{};
+	try
+	{
+		ex.run(tasks,thrower);
+	}
+	catch(fast_io::posix_error const&)
+	{
+		thrown=true;
+	}
+	if(!thrown||done.load()!=tasks-1)
+		panicln("the exception of a task was lost");
+#endif
+	std::vector<std::size_t> vec(1000000);
+	for(std::size_t i{};i!=vec.size();++i)
+		vec[i]=i*2654435761u;
+	{
+		fast_io::obuf_file obf("parallel_executor.txt");
+		print(obf,fast_io::parallel(vec,[](auto const& e)
+		{
+			return fast_io::line(e);
+		}));
+	}
+	fast_io::ibuf_file ibf("parallel_executor.txt");
+	for(std::size_t i{};i!=vec.size();++i)
+	{
+		std::size_t value{};
+		scan(ibf,value);
+		if(value!=vec[i])
+			panicln("parallel output differs at ",i);
+	}
+	println(fast_io::out(),"ok");
+}
@@ -0,0 +1,83 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+#include<vector>
+
+/*
+Floating point values, strings and parallel_counter output have no useful bound on their width, so workers print them
+into segments. The output of parallel, through a buffered file and straight into a native file, must be byte for byte
+what a sequential print gives.
+*/
+
+inline std::string read_all(char const* name)
+{
+	fast_io::inative_file nf(name);
+	std::string s;
+	char buffer[65536];
+	for(char* e;(e=read(nf,buffer,buffer+sizeof(buffer)))!=buffer;)
+		s.append(buffer,e);
+	return s;
+}
+
+template<typename F,typename G>
+inline void compare(char const* what,F sequential,G parallel)
+{
+	{
+		fast_io::obuf_file obf("parallel_print_sequential.txt");
+		sequential(obf);
+	}
+	{
+		fast_io::obuf_file obf("parallel_print_obuf.txt");
+		parallel(obf);
+	}
+	{
+		fast_io::onative_file onf("parallel_print_native.txt");
+		parallel(onf);
+	}
+	auto const expected{read_all("parallel_print_sequential.txt")};
+	if(read_all("parallel_print_obuf.txt")!=expected)
+		panicln(fast_io::chvw(what),": parallel output through obuf_file differs");
+	if(read_all("parallel_print_native.txt")!=expected)
+		panicln(fast_io::chvw(what),": parallel output into onative_file differs");
+}
+
+int main()
+{
+	std::vector<double> values(1000000);
+	for(std::size_t i{};i!=values.size();++i)
+		values[i]=static_cast<double>(i*2654435761u%1000000007u)/(1.0+static_cast<double>(i%1000))*(i%2?-1e-7:1e9);
+	compare("double",[&](auto& out)
+	{
+		for(auto const& e : values)
+			println(out,e);
+	},[&](auto& out)
+	{
+		print(out,fast_io::parallel(values,[](double e)
+		{
+			return fast_io::line(e);
+		}));
+	});
+	std::vector<std::string> strings(200000);
+	for(std::size_t i{};i!=strings.size();++i)
+		strings[i].assign(i%300,static_cast<char>('a'+i%26));
+	compare("string",[&](auto& out)
+	{
+		for(auto const& e : strings)
+			print(out,e);
+	},[&](auto& out)
+	{
+		print(out,fast_io::parallel(strings));
+	});
+	compare("parallel_counter",[&](auto& out)
+	{
+		for(std::size_t i{};i!=500000;++i)
+			println(out,i," ",values[i]);
+	},[&](auto& out)
+	{
+		print(out,fast_io::parallel_counter([&](auto& output,std::size_t first,std::size_t last)
+		{
+			for(;first!=last;++first)
+				println(output,first," ",values[first]);
+		},500000));
+	});
+	println(fast_io::out(),"ok");
+}
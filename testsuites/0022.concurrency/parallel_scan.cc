@@ -0,0 +1,79 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+#include<vector>
+
+/*
+parallel_scan must give what a sequential scan gives, on the contiguous path of imap_file and on the block path of
+ibuf_file. Small chunks and blocks put many cuts and carried tokens in the input. A malformed token must throw.
+*/
+
+template<typename input>
+inline void compare(char const* path,std::vector<std::size_t> const& expected,input& in,fast_io::parallel_scan_options const& options)
+{
+	auto values{fast_io::parallel_scan<std::size_t>(in,options)};
+	if(values.size()!=expected.size())
+		panicln(fast_io::chvw(path),": ",values.size()," values instead of ",expected.size());
+	for(std::size_t i{};i!=values.size();++i)
+		if(values[i]!=expected[i])
+			panicln(fast_io::chvw(path),": value ",i," is ",values[i]," instead of ",expected[i]);
+}
+
+int main()
+{
+	{
+		fast_io::obuf_file obf("parallel_scan.txt");
+		for(std::size_t i{};i!=300000;++i)
+		{
+			print(obf,i*2654435761u%1000000007u);
+			print(obf,fast_io::chvw(i%7==0?"\n":(i%5==0?" \t ":" ")));
+		}
+	}
+	std::vector<std::size_t> expected;
+	{
+		fast_io::ibuf_file ibf("parallel_scan.txt");
+		for(std::size_t v;scan<true>(ibf,v);)
+			expected.push_back(v);
+	}
+	fast_io::parallel_scan_options options;
+	options.min_chunk_size=4096;
+	options.block_size=65536;
+	{
+		fast_io::imap_file im("parallel_scan.txt");
+		compare("contiguous",expected,im,options);
+	}
+	{
+		fast_io::ibuf_file ibf("parallel_scan.txt");
+		compare("block",expected,ibf,options);
+	}
+#ifdef __cpp_exceptions
+	{
+		fast_io::obuf_file obf("parallel_scan_bad.txt");
+		for(std::size_t i{};i!=100000;++i)
+			println(obf,i==77777?std::string("12abc"):std::to_string(i));
+	}
+	for(std::size_t path{};path!=2;++path)
+	{
+		bool thrown{};
+		try
+		{
+			if(path==0)
+			{
+				fast_io::imap_file im("parallel_scan_bad.txt");
+				fast_io::parallel_scan<std::size_t>(im,options);
+			}
+			else
+			{
+				fast_io::ibuf_file ibf("parallel_scan_bad.txt");
+				fast_io::parallel_scan<std::size_t>(ibf,options);
+			}
+		}
+		catch(fast_io::fast_io_text_error const&)
+		{
+			thrown=true;
+		}
+		if(!thrown)
+			panicln("a malformed token was not reported");
+	}
+#endif
+	println(fast_io::out(),"ok");
+}
@@ -0,0 +1,93 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+#include<thread>
+#include<vector>
+
+/*
+Producers race on small rings, so the block policy keeps waiting for room and the grow policy keeps chaining larger
+rings. Some records are larger than the first ring. Every record must reach the file once, whole, and in order per
+producer. An error of the sink must come out of flush and close.
+*/
+
+template<fast_io::ring_log_overflow policy>
+inline void test(char const* name)
+{
+	constexpr std::size_t threads{8};
+	constexpr std::size_t records{50000};
+	{
+		fast_io::basic_ring_log<fast_io::onative_file,policy,32,64> log(name);
+		std::vector<std::jthread> pool;
+		for(std::size_t t{};t!=threads;++t)
+			pool.emplace_back([&log,t]
+			{
+				for(std::size_t i{};i!=records;++i)
+				{
+					if(i%1000==0)
+						println(log,t," ",i," ",std::string(1+i%5000,'x'));
+					else
+						println(log,t," ",i," ",t^i);
+				}
+			});
+		pool.clear();
+		flush(log);
+	}
+	std::vector<std::size_t> next(threads);
+	fast_io::ibuf_file ibf(name);
+	for(std::size_t line{};line!=threads*records;++line)
+	{
+		std::size_t t{},i{};
+		scan(ibf,t,i);
+		if(threads<=t)
+			panicln(fast_io::chvw(name),": record ",line," is torn");
+		if(i%1000==0)
+		{
+			std::string s;
+			scan(ibf,s);
+			if(s.size()!=1+i%5000)
+				panicln(fast_io::chvw(name),": record ",line," is torn");
+		}
+		else
+		{
+			std::size_t check{};
+			scan(ibf,check);
+			if(check!=(t^i))
+				panicln(fast_io::chvw(name),": record ",line," is torn");
+		}
+		if(next[t]!=i)
+			panicln(fast_io::chvw(name),": record ",line," is out of order");
+		++next[t];
+	}
+}
+
+#ifdef __cpp_exceptions
+template<typename F>
+inline void expect_enospc(char const* what,F f)
+{
+	try
+	{
+		f();
+	}
+	catch(fast_io::posix_error const& e)
+	{
+		if(e.code()==ENOSPC)
+			return;
+	}
+	panicln(fast_io::chvw(what)," did not report the error of the sink");
+}
+#endif
+
+int main()
+{
+	test<fast_io::ring_log_overflow::block>("ring_log_block.txt");
+	test<fast_io::ring_log_overflow::grow>("ring_log_grow.txt");
+#ifdef __cpp_exceptions
+	{
+		fast_io::basic_ring_log<fast_io::onative_file> log("/dev/full");
+		println(log,"lost");
+		expect_enospc("flush",[&]{flush(log);});
+		println(log,"lost again");
+		expect_enospc("close",[&]{log.close();});
+	}
+#endif
+	println(fast_io::out(),"ok");
+}
@@ -0,0 +1,59 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+
+/*
+The sized random_access_transmit is instantiated with a signed and an unsigned byte count, next to the unsized one and
+parallel_random_access_transmit. Every copy must hold exactly the requested range of the source.
+*/
+
+inline std::string read_all(char const* name)
+{
+	fast_io::native_file nf(name,fast_io::open_mode::in);
+	std::string s;
+	char buf[4096];
+	for(char* e;(e=read(nf,buf,buf+sizeof(buf)))!=buf;)
+		s.append(buf,e);
+	return s;
+}
+
+inline void check(char const* name,std::string const& source,std::size_t offset,std::size_t bytes,std::uintmax_t transmitted)
+{
+	if(transmitted!=bytes)
+		panicln(fast_io::chvw(name),": transmitted ",transmitted," instead of ",bytes);
+	if(read_all(name)!=source.substr(offset,bytes))
+		panicln(fast_io::chvw(name),": content differs");
+}
+
+int main()
+{
+	std::string source;
+	for(std::size_t i{};i!=200000;++i)
+		source.push_back(static_cast<char>('a'+i*7%26));
+	{
+		fast_io::onative_file onf("ra_source.txt");
+		write(onf,source.data(),source.data()+source.size());
+	}
+	fast_io::native_file in("ra_source.txt",fast_io::open_mode::in);
+	{
+		fast_io::onative_file onf("ra_signed.txt");
+		long const transmitted{random_access_transmit(onf,100,in,150000l)};
+		check("ra_signed.txt",source,100,150000,static_cast<std::uintmax_t>(transmitted));
+	}
+	{
+		fast_io::onative_file onf("ra_unsigned.txt");
+		std::size_t const transmitted{random_access_transmit(onf,4096,in,static_cast<std::size_t>(70000))};
+		check("ra_unsigned.txt",source,4096,70000,transmitted);
+	}
+	{
+		fast_io::onative_file onf("ra_rest.txt");
+		check("ra_rest.txt",source,12345,source.size()-12345,random_access_transmit(onf,12345,in));
+	}
+	{
+		fast_io::onative_file onf("ra_parallel.txt");
+		fast_io::parallel_transmit_options options;
+		options.threads=4;
+		options.chunk_size=16384;
+		check("ra_parallel.txt",source,777,150000,parallel_random_access_transmit(onf,777,in,150000u,{},options));
+	}
+	println(fast_io::out(),"ok");
+}
@@ -0,0 +1,71 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+
+/*
+Small buffers make the producer hand a buffer to the flusher thread every few records, and payloads larger than a
+buffer go through the cold write path. Everything printed before flush must be in the file when flush returns, and the
+whole file must read back in order. An error of the flusher must come out of flush.
+*/
+
+int main()
+{
+	constexpr std::size_t records{200000};
+	std::string large(10000,'z');
+	{
+		fast_io::basic_background_obuf<fast_io::onative_file,3,4096> obf("background_obuf.txt");
+		for(std::size_t i{};i!=records;++i)
+		{
+			if(i%10000==0)
+			{
+				print(obf,i," ");
+				println(obf,large);
+			}
+			else
+				println(obf,i);
+			if(i==records/2)
+			{
+				flush(obf);
+				fast_io::inative_file nf("background_obuf.txt");
+				std::size_t lines{};
+				char buffer[4096];
+				for(char* e;(e=read(nf,buffer,buffer+sizeof(buffer)))!=buffer;)
+					lines+=static_cast<std::size_t>(std::count(buffer,e,'\n'));
+				if(lines!=i+1)
+					panicln("flush left ",i+1-lines," records in the buffers");
+			}
+		}
+	}
+	fast_io::ibuf_file ibf("background_obuf.txt");
+	for(std::size_t i{};i!=records;++i)
+	{
+		std::size_t value{};
+		scan(ibf,value);
+		if(value!=i)
+			panicln("record ",i," reads back as ",value);
+		if(i%10000==0)
+		{
+			std::string s;
+			scan(ibf,s);
+			if(s!=large)
+				panicln("large record ",i," is torn");
+		}
+	}
+#ifdef __cpp_exceptions
+	bool thrown{};
+	{
+		fast_io::basic_background_obuf<fast_io::onative_file,2,4096> full("/dev/full");
+		try
+		{
+			println(full,"lost");
+			flush(full);
+		}
+		catch(fast_io::posix_error const& e)
+		{
+			thrown=e.code()==ENOSPC;
+		}
+	}
+	if(!thrown)
+		panicln("the error of the flusher was lost");
+#endif
+	println(fast_io::out(),"ok");
+}
@@ -0,0 +1,45 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+#include<thread>
+
+/*
+Payloads of at least a whole buffer go out together with the pending buffer in one writev. Into a pipe that a slow
+reader drains, the writev stops short, often inside the pending buffer or the payload, and must resume where it
+stopped. The reader must see every byte once and in order.
+*/
+
+static_assert(fast_io::scatter_output_stream<fast_io::posix_file>);
+
+int main()
+{
+	std::string expected;
+	int fds[2];
+	if(::pipe(fds)==-1)
+		fast_io::throw_posix_error();
+	fast_io::posix_file in_end(fds[0]);
+	std::string got;
+	std::jthread reader([&]
+	{
+		char buffer[3000];
+		for(char* e;(e=read(in_end,buffer,buffer+sizeof(buffer)))!=buffer;)
+			got.append(buffer,e);
+	});
+	{
+//the write end is closed with the stream, so the reader sees the end of the pipe
+		fast_io::basic_obuf<fast_io::posix_file> obf(fds[1]);
+		std::size_t const capacity{obf.obuffer.capacity()};
+		for(std::size_t i{};i!=200;++i)
+		{
+			std::string small(i%97,static_cast<char>('a'+i%26));
+			print(obf,small);
+			expected.append(small);
+			std::string large(capacity+i*4099,static_cast<char>('A'+i%26));
+			write(obf,large.data(),large.data()+large.size());
+			expected.append(large);
+		}
+	}
+	reader.join();
+	if(got!=expected)
+		panicln("the reader got ",got.size()," bytes that differ from the ",expected.size()," written");
+	println(fast_io::out(),"ok");
+}
@@ -0,0 +1,89 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+#include"../../include/fast_io_driver/liburing.h"
+#include<chrono>
+#include<memory>
+#include<string_view>
+#include<vector>
+
+/*
+The async callbacks only queue SQEs. Nothing reaches the kernel before the next wait, reap or poll, and queueing more
+operations than the ring has entries must still run each of them exactly once. A failed operation gets its negated
+errno and does not stop the rest of the batch. An SQPOLL ring must complete the same operations.
+*/
+
+int main()
+{
+	constexpr std::string_view message{"0123456789abcdef"};
+	{
+		fast_io::onative_file onf("batched_submission.txt");
+		write(onf,message.data(),message.data()+message.size());
+	}
+	fast_io::inative_file nf("batched_submission.txt");
+	auto const piob{static_cast<fast_io::posix_io_observer>(nf)};
+	constexpr std::size_t ops{200};
+	auto results{std::make_unique<std::ptrdiff_t[]>(ops)};
+	auto buffers{std::make_unique<char[]>(ops*4)};
+	std::size_t done{};
+	struct callback
+	{
+		std::ptrdiff_t* results;
+		std::size_t* done;
+		std::size_t i;
+		void operator()(std::ptrdiff_t res) noexcept
+		{
+			results[i]=res;
+			++*done;
+		}
+	};
+	std::vector<fast_io::io_uring_overlapped> overlapped;
+	overlapped.reserve(ops);
+	for(std::size_t i{};i!=ops;++i)
+		overlapped.emplace_back(std::in_place,callback{results.get(),std::addressof(done),i});
+	fast_io::io_uring ring(fast_io::io_uring_options{.entries=16});
+	for(std::size_t i{};i!=8;++i)
+		async_read_callback(ring,piob,buffers.get()+i*4,buffers.get()+i*4+4,overlapped[i],static_cast<std::ptrdiff_t>(i%4*4));
+	if(fast_io::pending_submissions(ring)!=8||done!=0)
+		panicln("the callbacks did not just queue their SQEs");
+	for(;done!=8;)
+		fast_io::io_async_wait(ring);
+	if(fast_io::pending_submissions(ring)!=0)
+		panicln("the wait left SQEs behind");
+	for(std::size_t i{};i!=ops;++i)
+		results[i]=-1;
+	done=0;
+	fast_io::posix_io_observer const bad{-1};
+	for(std::size_t i{};i!=ops;++i)
+	{
+		auto const target{i==ops/2?bad:piob};
+		async_read_callback(ring,target,buffers.get()+i*4,buffers.get()+i*4+4,overlapped[i],static_cast<std::ptrdiff_t>(i%4*4));
+	}
+	for(;done!=ops;)
+		fast_io::io_async_wait(ring);
+	for(std::size_t i{};i!=ops;++i)
+	{
+		if(i==ops/2)
+		{
+			if(results[i]!=-EBADF)
+				panicln("the failed read got ",results[i]," instead of -EBADF");
+			continue;
+		}
+		auto const expected{message.substr(i%4*4,4)};
+		if(results[i]!=4||std::string_view(buffers.get()+i*4,4)!=expected)
+			panicln("read ",i," of the batch gave ",results[i]);
+	}
+	using namespace std::chrono_literals;
+	if(fast_io::io_async_peek(ring)||fast_io::io_async_busy_poll(ring,1ms)!=0)
+		panicln("an idle ring reaped a completion");
+	fast_io::io_uring sq(fast_io::io_uring_options{.entries=32,.sqpoll=true,.sq_thread_idle=10});
+	done=0;
+	for(std::size_t i{};i!=64;++i)
+		async_read_callback(sq,piob,buffers.get()+i*4,buffers.get()+i*4+4,overlapped[i],static_cast<std::ptrdiff_t>(i%4*4));
+	for(;done!=64;)
+		if(!fast_io::io_async_busy_poll(sq,100ms))
+			fast_io::io_async_wait(sq);
+	for(std::size_t i{};i!=64;++i)
+		if(results[i]!=4||std::string_view(buffers.get()+i*4,4)!=message.substr(i%4*4,4))
+			panicln("read ",i," on the SQPOLL ring gave ",results[i]);
+	println(fast_io::out(),"ok");
+}
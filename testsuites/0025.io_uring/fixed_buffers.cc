@@ -0,0 +1,54 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+#include"../../include/fast_io_driver/liburing.h"
+#include<cstring>
+#include<string_view>
+
+/*
+Registered buffers and fixed files must move the same bytes as plain fds and buffers, in every combination. acquire()
+hands out each buffer once and an empty one after that. A fixed file slot that is removed is used again by the next add.
+*/
+
+int main()
+{
+	fast_io::io_uring ring(fast_io::io_uring_options{.entries=64});
+	fast_io::io_uring_fixed_buffers buffers(ring,4,4096);
+	fast_io::io_uring_fixed_files files(ring,8);
+	fast_io::native_file nf("fixed_buffers.txt",fast_io::open_mode::in|fast_io::open_mode::out|fast_io::open_mode::creat|fast_io::open_mode::trunc);
+	auto const piob{static_cast<fast_io::posix_io_observer>(nf)};
+	auto const ff{files.add(piob)};
+	if(files.available()!=7)
+		panicln("add did not take a slot");
+	std::ptrdiff_t result{};
+	fast_io::io_uring_overlapped ov(std::in_place,[&](std::ptrdiff_t res){result=res;});
+	constexpr std::string_view message{"hello fixed world"};
+	auto const wb{buffers.acquire()};
+	std::memcpy(wb.data,message.data(),message.size());
+	async_write_callback(ring,ff,wb.subspan(0,message.size()),ov);
+	fast_io::io_async_wait(ring);
+	if(result!=static_cast<std::ptrdiff_t>(message.size()))
+		panicln("WRITE_FIXED through a fixed file gave ",result);
+	auto const rb{buffers.acquire()};
+	async_read_callback(ring,piob,rb,ov);
+	fast_io::io_async_wait(ring);
+	if(result!=static_cast<std::ptrdiff_t>(message.size())||
+		std::string_view(reinterpret_cast<char const*>(rb.data),message.size())!=message)
+		panicln("READ_FIXED through the fd does not give back what was written");
+	char plain[6]{};
+	async_read_callback(ring,ff,plain,plain+5,ov,6);
+	fast_io::io_async_wait(ring);
+	if(result!=5||std::string_view(plain,5)!="fixed")
+		panicln("a plain read through a fixed file at an offset gave the wrong bytes");
+	auto const b3{buffers.acquire()},b4{buffers.acquire()};
+	if(!b3||!b4||buffers.acquire()||buffers.available()!=0)
+		panicln("acquire handed out more buffers than were registered");
+	if(wb.index==rb.index||wb.index==b3.index||rb.index==b4.index||b3.index==b4.index)
+		panicln("acquire handed out a buffer twice");
+	buffers.release(b4);
+	if(buffers.acquire().index!=b4.index)
+		panicln("a released buffer did not come back");
+	files.remove(ff);
+	if(files.available()!=8||files.add(piob).index!=ff.index)
+		panicln("a removed slot was not used again");
+	println(fast_io::out(),"ok");
+}
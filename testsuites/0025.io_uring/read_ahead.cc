@@ -0,0 +1,46 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+#include"../../include/fast_io_driver/liburing.h"
+
+/*
+basic_io_uring_ibuf keeps reads of the next chunks in flight. Small buffers make every few values cross a chunk, and
+the file does not end on a chunk boundary. Scanning and reading through it must give back exactly what was written.
+*/
+
+int main()
+{
+	constexpr std::size_t values{300000};
+	{
+		fast_io::obuf_file obf("read_ahead.txt");
+		for(std::size_t i{};i!=values;++i)
+			println(obf,i*2654435761u%1000000007u);
+	}
+	{
+		fast_io::basic_io_uring_ibuf<fast_io::inative_file,3,4096> ib("read_ahead.txt");
+		for(std::size_t i{};i!=values;++i)
+		{
+			std::size_t value{};
+			scan(ib,value);
+			if(value!=i*2654435761u%1000000007u)
+				panicln("value ",i," reads back as ",value);
+		}
+		std::size_t extra{};
+		if(scan<true>(ib,extra))
+			panicln("values after the last one");
+	}
+	std::string expected;
+	{
+		fast_io::inative_file nf("read_ahead.txt");
+		char buffer[65536];
+		for(char* e;(e=read(nf,buffer,buffer+sizeof(buffer)))!=buffer;)
+			expected.append(buffer,e);
+	}
+	fast_io::io_uring_ibuf_file ib("read_ahead.txt");
+	std::string got;
+	char buffer[10007];
+	for(char* e;(e=read(ib,buffer,buffer+sizeof(buffer)))!=buffer;)
+		got.append(buffer,e);
+	if(got!=expected)
+		panicln("read gave ",got.size()," bytes that differ from the ",expected.size()," in the file");
+	println(fast_io::out(),"ok");
+}
@@ -0,0 +1,133 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_network.h"
+#include"../../include/fast_io_driver/liburing.h"
+#include<atomic>
+#include<chrono>
+#include<string>
+#include<thread>
+#include<vector>
+
+/*
+One multishot accept must take every client, and the multishot receives share a provided buffer ring that is far
+smaller than what the clients send at once, so buffers have to be recycled for the echo to complete. close() sends
+pending output before closing. A throwing handler closes only its own connection, and stop() closes the idle ones.
+*/
+
+namespace
+{
+
+inline constexpr std::uint16_t port{23462};
+
+int connect_loopback()
+{
+	int fd{::socket(AF_INET,SOCK_STREAM|SOCK_CLOEXEC,0)};
+	if(fd==-1)
+		panicln("socket failed");
+	sockaddr_in addr{};
+	addr.sin_family=AF_INET;
+	addr.sin_port=htons(port);
+	addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+	if(::connect(fd,reinterpret_cast<sockaddr*>(std::addressof(addr)),sizeof(addr))==-1)
+		panicln("connect failed");
+	return fd;
+}
+
+void send_all(int fd,std::string_view str)
+{
+	for(;!str.empty();)
+	{
+		auto r{::send(fd,str.data(),str.size(),MSG_NOSIGNAL)};
+		if(r<=0)
+			panicln("send failed");
+		str.remove_prefix(static_cast<std::size_t>(r));
+	}
+}
+
+//read until the peer closes
+std::string recv_to_eof(int fd)
+{
+	std::string str;
+	char buffer[4096];
+	for(;;)
+	{
+		auto r{::recv(fd,buffer,sizeof(buffer),0)};
+		if(r<=0)
+			return str;
+		str.append(buffer,static_cast<std::size_t>(r));
+	}
+}
+
+}
+
+int main()
+{
+	fast_io::io_uring_socket_server server(port,{.entries=256,.buffer_count=64,.buffer_size=512});
+	std::jthread th([&]
+	{
+		server.run([](fast_io::io_uring_connection& conn,std::span<char const> bytes)
+		{
+			std::string_view str(bytes.data(),bytes.size());
+			if(str=="quit")
+			{
+				print(conn,"bye\n");
+				conn.close();
+			}
+			else if(str=="throw")
+				throw fast_io::posix_error(EINVAL);
+			else
+				write(conn,bytes.begin(),bytes.end());
+		});
+	});
+	std::atomic<std::size_t> finished{};
+	{
+		std::vector<std::jthread> clients;
+		for(std::size_t c{};c!=32;++c)
+			clients.emplace_back([&finished,c]
+			{
+				int fd{connect_loopback()};
+				std::string const message(1000+c*137,static_cast<char>('a'+c%26));
+				for(std::size_t round{};round!=50;++round)
+				{
+					send_all(fd,message);
+					std::string got;
+					char buffer[4096];
+					for(;got.size()<message.size();)
+					{
+						auto r{::recv(fd,buffer,sizeof(buffer),0)};
+						if(r<=0)
+							panicln("client ",c," lost its connection in round ",round);
+						got.append(buffer,static_cast<std::size_t>(r));
+					}
+					if(got!=message)
+						panicln("client ",c," got the wrong echo in round ",round);
+				}
+				send_all(fd,"quit");
+				if(recv_to_eof(fd)!="bye\n")
+					panicln("client ",c," did not get its reply before the close");
+				::close(fd);
+				finished.fetch_add(1,std::memory_order_relaxed);
+			});
+	}
+	if(finished.load()!=32)
+		panicln("not every client finished");
+	int thrower{connect_loopback()};
+	send_all(thrower,"throw");
+	if(!recv_to_eof(thrower).empty())
+		panicln("a throwing handler left output behind");
+	::close(thrower);
+	int idle{connect_loopback()};
+	int still{connect_loopback()};
+	send_all(still,"still here");
+	char buffer[16];
+	if(::recv(still,buffer,sizeof(buffer),0)!=10)
+		panicln("the server stopped serving after a handler threw");
+	using namespace std::chrono_literals;
+	std::this_thread::sleep_for(50ms);
+	server.stop();
+	th.join();
+	if(!recv_to_eof(idle).empty())
+		panicln("stop did not close the idle connection");
+	::close(idle);
+	::close(still);
+	println(fast_io::out(),"ok");
+}
@@ -0,0 +1,61 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_device.h"
+
+/*
+obuf_direct_file writes whole aligned blocks only. A flush in the middle pads the partial tail block, truncates the file
+back and rewrites that block later, and the file ends off a block boundary. The file must hold exactly what was printed,
+read back through ibuf_direct_file and through an ordinary ibuf_file.
+*/
+
+inline std::size_t value_of(std::size_t i) noexcept
+{
+	return i*2654435761u%1000000007u;
+}
+
+template<typename input>
+inline void check(char const* what,input& in,std::size_t values)
+{
+	for(std::size_t i{};i!=values;++i)
+	{
+		std::size_t value{};
+		scan(in,value);
+		if(value!=value_of(i))
+			panicln(fast_io::chvw(what),": value ",i," reads back as ",value);
+	}
+	std::size_t extra{};
+	if(scan<true>(in,extra))
+		panicln(fast_io::chvw(what),": values after the last one");
+}
+
+int main()
+{
+	constexpr std::size_t values{250000};
+	std::size_t bytes{};
+	{
+		fast_io::obuf_direct_file obf("direct_io.txt");
+		for(std::size_t i{};i!=values;++i)
+		{
+			char buffer[32];
+			auto e{fast_io::print_reserve_define(fast_io::io_reserve_type<std::size_t>,buffer,value_of(i))};
+			*e++='\n';
+			write(obf,buffer,e);
+			bytes+=static_cast<std::size_t>(e-buffer);
+			if(i==values/3)
+				flush(obf);
+		}
+	}
+	if(bytes%4096==0)
+		panicln("the file should end off a block boundary");
+	{
+		fast_io::inative_file nf("direct_io.txt");
+		if(static_cast<std::size_t>(seek(nf,0,fast_io::seekdir::end))!=bytes)
+			panicln("the file is not truncated to its logical size");
+	}
+	{
+		fast_io::ibuf_direct_file ibf("direct_io.txt");
+		check("ibuf_direct_file",ibf,values);
+	}
+	fast_io::ibuf_file ibf("direct_io.txt");
+	check("ibuf_file",ibf,values);
+	println(fast_io::out(),"ok");
+}
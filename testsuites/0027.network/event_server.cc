@@ -0,0 +1,116 @@
+#include"../../include/fast_io.h"
+#include"../../include/fast_io_network.h"
+#include<string>
+#include<thread>
+#include<vector>
+
+/*
+Every connection must get its own bytes back in order, whichever worker accepted it. A response larger than the
+socket buffer must drain through EPOLLOUT. close() sends pending output before closing, and a peer that shuts down
+its side still gets the echo of what it sent before EOF.
+*/
+
+namespace
+{
+
+inline constexpr std::uint16_t port{23461};
+
+int connect_loopback()
+{
+	int fd{::socket(AF_INET,SOCK_STREAM|SOCK_CLOEXEC,0)};
+	if(fd==-1)
+		panicln("socket failed");
+	sockaddr_in addr{};
+	addr.sin_family=AF_INET;
+	addr.sin_port=htons(port);
+	addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+	if(::connect(fd,reinterpret_cast<sockaddr*>(std::addressof(addr)),sizeof(addr))==-1)
+		panicln("connect failed");
+	return fd;
+}
+
+void send_all(int fd,std::string_view str)
+{
+	for(;!str.empty();)
+	{
+		auto r{::send(fd,str.data(),str.size(),MSG_NOSIGNAL)};
+		if(r<=0)
+			panicln("send failed");
+		str.remove_prefix(static_cast<std::size_t>(r));
+	}
+}
+
+//read until size bytes came or the peer closed
+std::string recv_some(int fd,std::size_t size)
+{
+	std::string str(size,0);
+	std::size_t got{};
+	for(;got!=size;)
+	{
+		auto r{::recv(fd,str.data()+got,size-got,0)};
+		if(r<=0)
+			break;
+		got+=static_cast<std::size_t>(r);
+	}
+	str.resize(got);
+	return str;
+}
+
+bool at_eof(int fd)
+{
+	char ch;
+	return ::recv(fd,std::addressof(ch),1,0)==0;
+}
+
+}
+
+int main()
+{
+	fast_io::event_server server(fast_io::ipv4{{127,0,0,1}},port,{.threads=3});
+	std::string const big(8000000,'z');
+	std::jthread th([&]
+	{
+		server.run([&](fast_io::event_connection& conn,std::span<char const> bytes)
+		{
+			std::string_view str(bytes.data(),bytes.size());
+			if(str=="big")
+				write(conn,big.data(),big.data()+big.size());
+			else
+			{
+				print(conn,str);
+				if(str.ends_with('!'))
+					conn.close();
+			}
+		});
+	});
+	constexpr std::size_t clients{500};
+	std::vector<int> fds(clients);
+	for(auto& fd : fds)
+		fd=connect_loopback();
+	for(std::size_t round{};round!=3;++round)
+	{
+		for(std::size_t i{};i!=clients;++i)
+			send_all(fds[i],fast_io::concat("ping ",i," ",round));
+		for(std::size_t i{};i!=clients;++i)
+		{
+			auto expected{fast_io::concat("ping ",i," ",round)};
+			if(recv_some(fds[i],expected.size())!=expected)
+				panicln("connection ",i," got the wrong echo in round ",round);
+		}
+	}
+	send_all(fds[0],"big");
+	if(recv_some(fds[0],big.size())!=big)
+		panicln("the large response was cut short");
+	send_all(fds[1],"bye!");
+	if(recv_some(fds[1],4)!="bye!"||!at_eof(fds[1]))
+		panicln("close() did not send the pending output before closing");
+	send_all(fds[2],"hello");
+	::shutdown(fds[2],SHUT_WR);
+	if(recv_some(fds[2],5)!="hello"||!at_eof(fds[2]))
+		panicln("a half closed peer did not get its echo and EOF");
+	for(auto fd : fds)
+		::close(fd);
+	server.stop();
+	th.join();
+	println(fast_io::out(),"ok");
+}